@@ -2,645 +2,410 @@
 # include <stdlib.h>
 # include <stdbool.h>
 # include <string.h>
-# include <ctype.h>
+# include <pthread.h>
+# include <unistd.h>
+# include "studentsort.h"
 
 // Global error output
 const char *error_output;
 
-// Create a struct for the entity
-typedef struct Student {
-	char *first_name; // Alphabet
-	char *last_name; // Alphabet
-	char *birth_month; // Ranges from Jan to Dec
-	char *birth_day; // Ranges from 1 to 31
-	char *birth_year; // Ranges from 1950 to 2010
-	char *gpa; // Ranges from 0.0 to 4.3
-	char *status; // Either Domestic (D) or International (I)
-	char *toefl; // Ranges from 0 to 120
-
-	struct Student *next;
-} Student_t;
-
-// Create a wrapper struct to preserve order in StudentList_t
-typedef struct ListNode {
-	Student_t *student;
-	struct ListNode *next;
-} ListNode_t;
-
-// Create a struct that orders the each of the lists by status
-typedef struct StudentList {
-	ListNode_t *head_d; // Head of domestic list
-	ListNode_t *tail_d;
-	ListNode_t *head_i; // Head of international list
-	ListNode_t *tail_i;
-	ListNode_t *head_a; // Head of all list
-	ListNode_t *tail_a;
-} StudentList_t;
-
-// Months array
-const char *months[] = {
-	"Jan", "Feb", "Mar", "Apr", "May", "Jun", 
-	"Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
-};
+// Whether each job prints its stats, from --stats or STUDENTSORT_STATS
+bool stats_enabled;
 
-/**
- * Function to call error.
- * Prints error message and exits.
- */
-void callError(char *message) {
-	printf("%s\n", message);
-	printf("\n");
-	if (error_output == NULL) exit(1);
-	FILE *file = fopen(error_output, "w");
-	fprintf(file, "%s\n", message);
-	// fprintf(file, "\n");
-	fclose(file);
-	exit(1);
-}
-
-/**
- * Function to create a node.
- * Dynamically allocates memory for the node.
- * If the node is NULL, then error.
- */
-Student_t *createNode() {
-	Student_t *node = (Student_t *) malloc(sizeof(Student_t));
-	if (node == NULL) callError("Error: Memory could not be allocated.");
-
-	node->first_name = NULL;
-	node->last_name = NULL;
-	node->birth_month = NULL;
-	node->birth_day = NULL;
-	node->birth_year = NULL;
-	node->gpa = NULL;
-	node->status = NULL;
-	node->toefl = NULL;
-	node->next = NULL;
-
-	return node;
-}
+// Sort order compiled from --key, and the text it was compiled from
+ss_SortKey_t sort_key;
+const char *key_spec;
 
-/**
- * Function to wrap a Student_t node in a ListNode_t node.
- * If the head is NULL, then the head is the node.
- */
-void appendToList(ListNode_t **head, ListNode_t **tail, Student_t *student) {
-	ListNode_t *node = (ListNode_t *) malloc(sizeof(ListNode_t));
-	if (node == NULL) callError("Error: Memory could not be allocated.");
-	node->student = student;
-	node->next = NULL;
-
-	if (*head == NULL) *head = node;
-	else (*tail)->next = node;
-	*tail = node;
-}
+// Manifest of jobs for --batch, NULL for one job
+const char *batch_name;
 
-/**
- * Function to append a node to the end of the linked list.
- */
-void appendList(StudentList_t *list, Student_t *new_node) {
-	if (list == NULL || new_node == NULL) callError("Error: NULL argument.");
-
-	// Append to all list
-	appendToList(&list->head_a, &list->tail_a, new_node);
-
-	// Append to domestic or international list
-	if (new_node->status != NULL) {
-		switch (new_node->status[0]) {
-			case 'D': appendToList(&list->head_d, &list->tail_d, new_node); break;
-			case 'I': appendToList(&list->head_i, &list->tail_i, new_node); break;
-			default: callError("Error: Invalid status.");
-		}
-	}
-}
+// Batch jobs to run at once, from --jobs
+int batch_jobs = 1;
 
-/**
- * Function to free the linked list.
- * Frees by all fields.
- */
-void freeList(ListNode_t *node) {
-	while (node != NULL) {
-		ListNode_t *temp = node;
-		node = node->next;
-
-		// Free dynamically allocated strings within the node
-		if (temp->student->first_name != NULL) free(temp->student->first_name);
-		if (temp->student->last_name != NULL) free(temp->student->last_name);
-		if (temp->student->birth_month != NULL) free(temp->student->birth_month);
-		if (temp->student->birth_day != NULL) free(temp->student->birth_day);
-		if (temp->student->birth_year != NULL) free(temp->student->birth_year);
-		if (temp->student->gpa != NULL) free(temp->student->gpa);
-		if (temp->student->status != NULL) free(temp->student->status);
-		if (temp->student->toefl != NULL) free(temp->student->toefl);
-		
-		free(temp->student);
-		free(temp);
-	}
-}
+// Name of the executable, for the usage
+const char *program_name;
 
-/**
- * Function to compare by year.
- * NULL precedes non-NULL.
- */
-int compareByYear(Student_t *a, Student_t *b) {
-	if (a->birth_year == NULL && b->birth_year != NULL) return 1;
-	if (a->birth_year != NULL && b->birth_year == NULL) return -1;
-	if (a->birth_year == NULL && b->birth_year == NULL) return 0;
-
-	if (atoi(a->birth_year) < atoi(b->birth_year)) return -1; // a is less than b
-	if (atoi(a->birth_year) > atoi(b->birth_year)) return 1; // a is greater than b
-	return 0; // a is equal to b
-}
+// Create a struct for a batch of jobs shared by the workers
+typedef struct Batch {
+	ss_Options_t *jobs; // Options of each job, from the manifest and the flags
+	ss_Result_t *results; // Outcome of each job
+	int job_count;
+	int next_job; // Next job to take, guarded by lock
+	pthread_mutex_t lock;
+} Batch_t;
 
 /**
- * Function to compare by month.
+ * Function to report an error.
+ * Prints error message and writes it to the output file, if there is one.
  */
-int compareByMonth(Student_t *a, Student_t *b) {
-	if (a->birth_month == NULL && b->birth_month != NULL) return 1;
-	if (a->birth_month != NULL && b->birth_month == NULL) return -1;
-	if (a->birth_month == NULL && b->birth_month == NULL) return 0;
-
-	// Get the index of the month from the months array
-	int a_index = 0;
-	int b_index = 0;
-
-	for (int i = 0; i < 12; i++) {
-		if (strcmp(a->birth_month, months[i]) == 0) a_index = i;
-		if (strcmp(b->birth_month, months[i]) == 0) b_index = i;
+void reportError(const char *output_name, const char *message) {
+	printf("%s\n", message);
+	printf("\n");
+	if (output_name != NULL) {
+		FILE *file = fopen(output_name, "w");
+		if (file != NULL) {
+			fprintf(file, "%s\n", message);
+			// fprintf(file, "\n");
+			fclose(file);
+		}
 	}
-
-	if (a_index < b_index) return -1; // a is less than b
-	if (a_index > b_index) return 1; // a is greater than b
-	return 0; // a is equal to b
 }
 
 /**
- * Function to compare by day.
- * NULL precedes non-NULL.
- */
-int compareByDay(Student_t *a, Student_t *b) {
-	if (a->birth_day == NULL && b->birth_day != NULL) return 1;
-	if (a->birth_day != NULL && b->birth_day == NULL) return -1;
-	if (a->birth_day == NULL && b->birth_day == NULL) return 0;
-
-	if (atoi(a->birth_day) < atoi(b->birth_day)) return -1; // a is less than b
-	if (atoi(a->birth_day) > atoi(b->birth_day)) return 1; // a is greater than b
-	return 0; // a is equal to b
-}
-
-/**
- * Function to compare by last name.
- * NULL precedes non-NULL.
- */
-int compareByLastName(Student_t *a, Student_t *b) {
-	if (a->last_name == NULL && b->last_name != NULL) return 1;
-	if (a->last_name != NULL && b->last_name == NULL) return -1;
-	if (a->last_name == NULL && b->last_name == NULL) return 0;
-
-	return strcmp(a->last_name, b->last_name);
-}
-
-/**
- * Function to compare by first name.
- * NULL precedes non-NULL.
- */
-int compareByFirstName(Student_t *a, Student_t *b) {
-	if (a->first_name == NULL && b->first_name != NULL) return 1;
-	if (a->first_name != NULL && b->first_name == NULL) return -1;
-	if (a->first_name == NULL && b->first_name == NULL) return 0;
-
-	return strcmp(a->first_name, b->first_name);
-}
-
-/**
- * Function to compare by GPA.
- * NULL precedes non-NULL.
- */
-int compareByGPA(Student_t *a, Student_t *b) {
-	if (a->gpa == NULL && b->gpa != NULL) return 1;
-	if (a->gpa != NULL && b->gpa == NULL) return -1;
-	if (a->gpa == NULL && b->gpa == NULL) return 0;
-
-	double gpa_a = atof(a->gpa);
-	double gpa_b = atof(b->gpa);
-
-	if (gpa_a < gpa_b) return -1; // a is less than b
-	if (gpa_a > gpa_b) return 1; // a is greater than b
-	return 0; // a is equal to b
-}
-
-/**
- * Function to compare by TOEFL.
- * Domestic precedes international.
- */
-int compareByTOEFL(Student_t *a, Student_t *b) {
-	// If no TOEFL, then domestic
-	if (a->toefl == NULL && b->toefl != NULL) return -1; // a is domestic, b is international
-	if (a->toefl != NULL && b->toefl == NULL) return 1; // a is international, b is domestic
-	if (a->toefl == NULL && b->toefl == NULL) return 0; // Both are domestic
-
-	// Both have TOEFL, so compare
-	int toefl_a = atoi(a->toefl);
-	int toefl_b = atoi(b->toefl);
-
-	if (toefl_a < toefl_b) return -1; // a is less than b
-	if (toefl_a > toefl_b) return 1; // a is greater than b
-	return 0; // a is equal to b
-}
-
-/**
- * Function to compare by status.
- * Domestic precedes international.
+ * Function to call error.
+ * Prints error message and exits.
  */
-int compareByStatus(Student_t *a, Student_t *b) {
-	if (a->status == NULL && b->status != NULL) return 1;
-	if (a->status != NULL && b->status == NULL) return -1;
-	if (a->status == NULL && b->status == NULL) return 0;
-
-	return strcmp(a->status, b->status);
+void callError(const char *message) {
+	reportError(error_output, message);
+	exit(1);
 }
 
 /**
- * Function to compare two students.
- * Compares by all fields.
+ * Function to print the usage of the program.
  */
-int compareStudents(Student_t *a, Student_t *b) {
-	int result;
-
-	// Use each compare function in the given order until a difference is found
-	if ((result = compareByYear(a, b)) != 0) return result;
-	if ((result = compareByMonth(a, b)) != 0) return result;
-	if ((result = compareByDay(a, b)) != 0) return result;
-	if ((result = compareByLastName(a, b)) != 0) return result;
-	if ((result = compareByFirstName(a, b)) != 0) return result;
-	if ((result = compareByGPA(a, b)) != 0) return result;
-	if ((result = compareByTOEFL(a, b)) != 0) return result;
-	if ((result = compareByStatus(a, b)) != 0) return result;
-
-	return 0; // a is equal to b
+void printUsage(const char *program) {
+	printf("Usage %s [--sort merge|radix|natural|parallel] [--key <fields>] [--threads <count>] "
+		"[--memory <megabytes>] [--top <count>] [--snapshot <file>] [--cache <directory>] "
+		"[--cache-size <megabytes>] [--stats] <input_file> <output_file> <option>\n", program);
+	printf("      %s [flags] [--jobs <count>] --batch <manifest_file>\n", program);
 }
 
 /**
- * Function to split a linked list into two halves.
- * Splits by all fields.
+ * Function to read the command line arguments into options.
+ * Flags start with -- and may appear anywhere. The rest are positional.
  */
-void splitList(ListNode_t *head, ListNode_t **left, ListNode_t **right) {
-	if (head == NULL || head->next == NULL) {
-		*left = head;
-		*right = NULL;
-		return;
-	}
-
-	ListNode_t *slow = head;
-	ListNode_t *fast = head->next;
-
-	while (fast != NULL) {
-		fast = fast->next;
-		if (fast != NULL) {
-			slow = slow->next;
-			fast = fast->next;
+void parseArguments(int argc, char *argv[], ss_Options_t *options) {
+	const char *positional[3];
+	int positional_count = 0;
+
+	ss_initOptions(options);
+	program_name = argv[0];
+
+	// Stats can also be turned on from the environment
+	const char *stats = getenv("STUDENTSORT_STATS");
+	if (stats != NULL && stats[0] != '\0' && strcmp(stats, "0") != 0) stats_enabled = true;
+
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--", 2) != 0) { // Positional argument
+			if (positional_count < 3) positional[positional_count] = argv[i];
+			positional_count++;
+		} else if (strcmp(argv[i], "--sort") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "merge") == 0) options->sort_mode = SS_SORT_MERGE;
+			else if (strcmp(argv[i], "radix") == 0) options->sort_mode = SS_SORT_RADIX;
+			else if (strcmp(argv[i], "natural") == 0) options->sort_mode = SS_SORT_NATURAL;
+			else if (strcmp(argv[i], "parallel") == 0) options->sort_mode = SS_SORT_PARALLEL;
+			else {
+				printUsage(argv[0]);
+				callError("Error: Invalid sort mode.");
+			}
+		} else if (strcmp(argv[i], "--key") == 0 && i + 1 < argc) {
+			ss_Result_t result;
+			key_spec = argv[++i];
+			if (!ss_compileSortKey(key_spec, &sort_key, &result)) {
+				printUsage(argv[0]);
+				callError(result.message);
+			}
+			options->key = &sort_key;
+		} else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			options->threads = atoi(argv[++i]);
+			if (options->threads < 1 || options->threads > 1024) {
+				printUsage(argv[0]);
+				callError("Error: Invalid number of threads.");
+			}
+		} else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+			long megabytes = atol(argv[++i]);
+			if (megabytes < 1) {
+				printUsage(argv[0]);
+				callError("Error: Invalid memory budget.");
+			}
+			options->memory = (size_t) megabytes * 1024 * 1024;
+		} else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+			long count = atol(argv[++i]);
+			if (count < 1) {
+				printUsage(argv[0]);
+				callError("Error: Invalid top count.");
+			}
+			options->top = (size_t) count;
+		} else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+			batch_name = argv[++i];
+		} else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+			options->snapshot_name = argv[++i];
+		} else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+			options->cache_name = argv[++i];
+		} else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+			long megabytes = atol(argv[++i]);
+			if (megabytes < 1) {
+				printUsage(argv[0]);
+				callError("Error: Invalid cache size.");
+			}
+			options->cache_size = (size_t) megabytes * 1024 * 1024;
+		} else if (strcmp(argv[i], "--stats") == 0) {
+			stats_enabled = true;
+		} else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+			batch_jobs = atoi(argv[++i]);
+			if (batch_jobs < 1 || batch_jobs > 1024) {
+				printUsage(argv[0]);
+				callError("Error: Invalid number of jobs.");
+			}
+		} else {
+			printUsage(argv[0]);
+			callError("Error: Invalid flag.");
 		}
 	}
 
-	*left = head;
-	*right = slow->next;
-	slow->next = NULL;
-}
-
-/**
- * Function to merge two linked lists.
- * Merges by all fields.
- */
-ListNode_t *mergeList(ListNode_t *left, ListNode_t *right) {
-	ListNode_t *result = NULL;
-
-	if (left == NULL) return right;
-	if (right == NULL) return left;
-
-	int compare = compareStudents(left->student, right->student);
-	if (compare <= 0) {
-		result = left;
-		result->next = mergeList(left->next, right);
-	} else {
-		result = right;
-		result->next = mergeList(left, right->next);
+	// A snapshot belongs to one input file
+	if (batch_name != NULL && options->snapshot_name != NULL) {
+		printUsage(argv[0]);
+		callError("Error: --snapshot cannot be used with --batch.");
 	}
 
-	return result;
-}
-
-/**
- * Function to sort a linked list using merge sort.
- * Sorts by all fields.
- */
-void sortList(ListNode_t **head) {
-	if (*head == NULL || (*head)->next == NULL) return;
-
-	ListNode_t *left = NULL;
-	ListNode_t *right = NULL;
-
-	splitList(*head, &left, &right);
-
-	sortList(&left);
-	sortList(&right);
-
-	*head = mergeList(left, right);
-}
-
-/**
- * Function to check if valid name.
- * Valid name contains letters.
- * Checks first last name.
- */
-void addFirstName(char *name, Student_t *node) {
-	char *error_message = "Error: Invalid first name.";
-
-	// If the name does not contain letters, error.
-	for (int i = 0; i < strlen(name); i++)
-		if (!isalpha(name[i])) callError(error_message);
+	// A batch takes its files and options from the manifest
+	if (batch_name != NULL && positional_count == 0) return;
 
-	node->first_name = strdup(name);
-	if (node->first_name == NULL) callError(error_message);
-}
-
-/**
- * Function to check if valid name.
- * Valid name contains letters.
- * Checks last name.
- */
-void addLastName(char *name, Student_t *node) {
-	char *error_message = "Error: Invalid last name.";
-
-	// If the name does not contain letters, error.
-	for (int i = 0; i < strlen(name); i++)
-		if (!isalpha(name[i])) callError(error_message);
-
-	node->last_name = strdup(name);
-	if (node->last_name == NULL) callError(error_message);
+	// Check if number of arguments is valid. Then get inputs.
+	if (positional_count != 3) {
+		printUsage(argv[0]);
+		callError("Error: Invalid number of arguments.");
+	}
+	options->input_name = positional[0]; // Input file name
+	options->output_name = positional[1]; // Output file name
+	options->option = atoi(positional[2]);
 }
 
 /**
- * Function to check if valid date.
- * Valid date contains numbers.
- * Checks month, day, and year.
+ * Function to print a string as a JSON string.
  */
-void addDate(char *date, Student_t *node) {
-	// Delimit each dash e.g., Month-Day-Year
-	int counter = 0;
-	char *delimiter = "-";
-	char *ptr;
-	char *data = strtok_r(date, delimiter, &ptr); 
-	char *end_ptr;
-
-	while (data != NULL) {
-		counter++;
-		switch (counter) {
-			case 1: // Month
-				// Check if equals to one of the months
-				for (int i = 0; i < 12; i++)
-					if (strcmp(data, months[i]) == 0) break;
-					else if (i == 11) callError("Error: Invalid month.");
-				node->birth_month = strdup(data);
-				if (node->birth_month == NULL) callError("Error: Invalid month.");
-				break;
-			case 2: // Day
-				// Check if number and not other characters
-				if (data[0] == '0') callError("Error: Invalid day."); // If leading zero, error
-				long day = strtol(data, &end_ptr, 10); // Convert string to int
-				
-				// Check if number is between 1 and 31
-				if (*end_ptr != '\0' || day < 1 || day > 31) callError("Error: Invalid day.");
-				node->birth_day = strdup(data);
-				if (node->birth_day == NULL) callError("Error: Invalid day.");
-				break;
-			case 3: // Year
-				// Check if number and not other characters
-				if (data[0] == '0') callError("Error: Invalid year."); // If leading zero, error
-				long year = strtol(data, &end_ptr, 10); // Convert string to int
-				
-				// Check if number is between 1950 and 2010
-				if (*end_ptr != '\0' || year < 1950 || year > 2010) callError("Error: Invalid year.");
-				node->birth_year = strdup(data);
-				if (node->birth_year == NULL) callError("Error: Invalid year.");
-				break;
-			default:
-				callError("Error: Invalid date format.");
-		}
-		data = strtok_r(NULL, delimiter, &ptr); // Gets the next string
+void printJsonString(FILE *file, const char *text) {
+	fputc('"', file);
+	for (const unsigned char *c = (const unsigned char *) text; c != NULL && *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') fprintf(file, "\\%c", *c);
+		else if (*c < 0x20) fprintf(file, "\\u%04x", *c);
+		else fputc(*c, file);
 	}
+	fputc('"', file);
 }
 
 /**
- * Function to check if valid GPA.
+ * Function to print the stats of a job as one line of JSON on stderr.
  */
-void addGPA(char *gpa, Student_t *node) {
-	char *error_message = "Error: Invalid GPA.";
-	if (gpa[0] == '0' && gpa[1] != '.') callError(error_message); // If leading zero, error
-
-	char *ptr;
-	double val = strtod(gpa, &ptr); // Convert string to double
-
-	if (*ptr != '\0') callError(error_message); // If there is a character, error
-	if (val < 0.0 || val > 4.3) callError(error_message); // If out of range, error
-	if (strlen(gpa) > 5) callError(error_message); // If more than 3 decimal places, error
-
-	node->gpa = strdup(gpa);
-	if (node->gpa == NULL) callError(error_message);
+void printStats(const ss_Options_t *options, const ss_Stats_t *stats, bool ok) {
+	// Build the line in memory so lines of concurrent jobs do not mix
+	char *text = NULL;
+	size_t length = 0;
+	FILE *line = open_memstream(&text, &length);
+	if (line == NULL) return;
+
+	const char *sort_names[] = {"merge", "radix", "natural", "parallel"};
+	fprintf(line, "{\"input\":");
+	printJsonString(line, options->input_name);
+	fprintf(line, ",\"output\":");
+	printJsonString(line, options->output_name);
+	fprintf(line, ",\"option\":%d", options->option);
+	if (options->key != NULL && options->key->custom) {
+		// A custom key sorts with its own encoded keys, whatever the sort mode
+		fprintf(line, ",\"sort\":\"keyed\",\"key\":");
+		printJsonString(line, key_spec);
+	} else {
+		fprintf(line, ",\"sort\":\"%s\"", sort_names[options->sort_mode]);
+	}
+	fprintf(line, ",\"ok\":%s", ok ? "true" : "false");
+	fprintf(line, ",\"seconds\":{\"read\":%.6f,\"sort\":%.6f,\"write\":%.6f}",
+		stats->read_seconds, stats->sort_seconds, stats->write_seconds);
+	fprintf(line, ",\"records\":{\"domestic\":%zu,\"international\":%zu,\"all\":%zu}",
+		stats->records_d, stats->records_i, stats->records_a);
+	fprintf(line, ",\"compares\":%llu,\"allocations\":%llu,\"bytes_read\":%llu,\"bytes_written\":%llu}\n",
+		(unsigned long long) stats->compares, (unsigned long long) stats->allocations,
+		(unsigned long long) stats->bytes_read, (unsigned long long) stats->bytes_written);
+	fclose(line);
+
+	fputs(text, stderr);
+	free(text);
 }
 
 /**
- * Function to check if valid status.
- * Valid status is either D or I.
+ * Function to read, sort and write one input file with the library.
+ * Prints the usage for an invalid option, and a line for each file written.
+ * With stats on, also prints the stats of the job on stderr.
+ * Returns false with the error in result.
  */
-void addStatus(char *status, Student_t *node) {
-	char *error_message = "Error: Invalid status.";
-	if (status == NULL || (strcmp(status, "D") != 0 && strcmp(status, "I") != 0)) callError(error_message);
-
-	node->status = strdup(status);
-	if (node->status == NULL) callError(error_message);
-}
+bool runJob(const ss_Options_t *options, ss_StudentList_t *list, ss_Result_t *result) {
+	// Each job fills in its own stats
+	ss_Options_t job = *options;
+	ss_Stats_t stats;
+	if (stats_enabled) job.stats = &stats;
+
+	bool done = ss_sortFile(&job, list, result);
+	if (job.stats != NULL) printStats(&job, &stats, done);
+	if (!done) {
+		if (result->code == SS_RESULT_INVALID_ARGUMENT) printUsage(program_name);
+		return false;
+	}
 
-/**
- * Function to check if valid TOEFL.
- * Valid TOEFL is between 0 and 120.
- */
-void addTOEFL(char *toefl, Student_t *node) {
-	char *error_message = "Error: Invalid TOEFL.";
-	
-	if ((strcmp(node->status, "D") == 0) && (toefl != NULL)) callError(error_message);
-	if ((strcmp(node->status, "I") == 0) && (toefl == NULL)) callError(error_message);
-
-	if (toefl != NULL) {
-		if (toefl[0] == '0' && toefl[1] == '0') callError(error_message);
-
-		char *end_ptr;
-		long val = strtol(toefl, &end_ptr, 10); // Convert string to int
-	
-		if (*end_ptr != '\0' || val < 0 || val > 120) callError(error_message); // If out of range, error
-
-		node->toefl = strdup(toefl);
-		if (node->toefl == NULL) callError(error_message);
+	// Option 4 writes three files
+	int files = (options->option == 4) ? 3 : 1;
+	for (int i = 0; i < files; i++) {
+		printf("Successfully wrote to output file.\n");
+		printf("\n");
 	}
+	return true;
 }
 
 /**
- * Function to process word into Student struct.
+ * Function to run the jobs of a batch on one worker.
+ * Each worker keeps one list, so its arena is reused from job to job.
  */
-void processWord(char *word, Student_t *current, int word_count) {
-	switch (word_count) {
-		case 1: addFirstName(word, current); break;
-		case 2: addLastName(word, current); break;
-		case 3: addDate(word, current); break;
-		case 4: addGPA(word, current); break;
-		case 5: addStatus(word, current); break;
-		case 6: addTOEFL(word, current); break;
-		default: callError("Error: Incorrect input format.");
+void *runWorker(void *arg) {
+	Batch_t *batch = (Batch_t *) arg;
+	ss_StudentList_t list;
+	memset(&list, 0, sizeof(list));
+
+	while (true) {
+		pthread_mutex_lock(&batch->lock);
+		int index = batch->next_job++;
+		pthread_mutex_unlock(&batch->lock);
+		if (index >= batch->job_count) break;
+
+		// An error ends only this job
+		ss_Result_t *result = &batch->results[index];
+		if (!runJob(&batch->jobs[index], &list, result)) reportError(batch->jobs[index].output_name, result->message);
 	}
-}
-
-/**
- * Function to read text from input file. 
- */ 
-void readFile(FILE *input, StudentList_t *list, const int option, char *encoding) {
-	if (input == NULL) callError("Error: Could not read file."); // Error handle reading file
-
-	Student_t *current = createNode();
-	int size = 20;
-	char *buffer = (char *) malloc(sizeof(char) * size);
-	if (buffer == NULL) callError("Error: Memory could not be allocated.");
-
-	char c;
-	char last_char;
-	char *word = buffer; // Pointer to buffer
-	int characters = 0;
-	int word_count = 0;
-	int word_length = 0;
-	int space_count = 0;
-	bool in_word = false;
-
-	while ((c = fgetc(input)) != EOF) {
-		if (ferror(input)) { // Error handle reading file
-			free(buffer);
-			fclose(input);
-			callError("Error: Could not read file.");
-		}
-		if (space_count > 1) { // Error handle consecutive spaces
-			free(buffer);
-			fclose(input);
-			callError("Error: Consecutive spaces is invalid format.");
-		}
-		if (word_count > 6) { // Error handle too many words
-			free(buffer);
-			fclose(input);
-			callError("Error: Too many fields."); 
-		}
-		if (word_length >= (size - 1)) { // Reallocate memory if word is too long
-			size *= 2;
-			char *temp = (char *) realloc(buffer, sizeof(char) * size);
-			if (temp == NULL) {
-				free(buffer);
-				fclose(input);
-				callError("Error: Memory could not be allocated.");
-			}
-			buffer = temp;
-			word = buffer + word_length; // Continue building string from last char
-		}
-
-		if (!isspace(c)) {
-			if (!in_word) { // Start of word 
-				word_count++;
-				space_count = 0;
-				in_word = true;
-			}
-			*word++ = c;
-			word_length++;
-		} else if (isspace(c)) {
-			if (c != '\r' && c != '\n' && word_count == 0) callError("Error: Leading spaces is invalid format."); // Error handle leading spaces
-		
-			if (in_word) { // End of word
-				*word = '\0';
-				processWord(buffer, current, word_count); // Process word	
-				word = buffer; // Reset word
-				memset(buffer, 0, 20); // Reset buffer
-				word_length = 0;
-				in_word = false;
-			}
-			if (c == '\r' ) {
-				*encoding = 'W';
-				char next_char = fgetc(input); // Peek next character
-				if (next_char != '\n') callError("Error: Carriage return is invalid format.");
-			}
-			space_count++;
-		}
-		// Reset word count if end of line
-		if ((c == '\r' || c == '\n') && space_count != 0) {
-			// Error handle empty line
-			// Only last line can be empty
-			if (word_count == 0) {
-				last_char = (char) c;
-				char next_char = fgetc(input); // Peek next character
-				if (next_char == EOF && characters != 0) break;
-				else callError("Error: Empty line is invalid format.");
-			}
-
-			// Error handle trailing spaces
-			if (space_count > 1) callError("Error: Trailing spaces is invalid format.");
 
-			// Append Student to linked list
-			appendList(list, current);
-			current = createNode();
-
-			// Reset counts for next line
-			word_count = 0;
-			space_count = 0;
-		}
-		characters++;
-	} // End of while loop
-	free(buffer);
-	if (last_char != 0 && last_char != '\r' && last_char != '\n') callError("Error: Last line is invalid format.");
+	ss_freeList(&list);
+	return NULL;
 }
 
 /**
- * Function to write text to output file.
- * Writes by all fields.
+ * Function to run every job of a batch manifest.
+ *
+ * Each line of the manifest is "<input_file> <output_file> <option>".
+ * Empty lines and lines starting with # are skipped. Flags given on the
+ * command line apply to every job. A job that fails writes its error to its
+ * output file like a single run would, and the batch goes on.
+ *
+ * Returns true if every job succeeded.
  */
-void writeFile(FILE *output, ListNode_t *head, const char *encoding) {
-	ListNode_t *current = head;
-	while (current != NULL) {
-		Student_t *student = current->student;
-		if (student->first_name != NULL) fprintf(output, "%s ", student->first_name);
-		if (student->last_name != NULL) fprintf(output, "%s ", student->last_name);
-		if (student->birth_month != NULL) fprintf(output, "%s-", student->birth_month);
-		if (student->birth_day != NULL) fprintf(output, "%s-", student->birth_day);
-		if (student->birth_year != NULL) fprintf(output, "%s ", student->birth_year);
-		if (student->gpa != NULL) fprintf(output, "%s ", student->gpa);
-		if (student->status != NULL && *student->status == 'D') fprintf(output, "%s", student->status);
-		else if (student->status != NULL && *student->status == 'I') fprintf(output, "%s ", student->status);
-		if (student->toefl != NULL) fprintf(output, "%s", student->toefl);
-		if (*encoding == 'U') fprintf(output, "\n");
-		else if (*encoding == 'W') fprintf(output, "\r\n");
-		current = current->next;
+bool runBatch(const ss_Options_t *options) {
+	FILE *manifest = fopen(batch_name, "r");
+	if (manifest == NULL) callError("Error: Batch file not found.");
+
+	Batch_t batch;
+	batch.jobs = NULL;
+	batch.job_count = 0;
+	batch.next_job = 0;
+	int size = 0;
+
+	char *line = NULL;
+	size_t line_size = 0;
+	while (getline(&line, &line_size, manifest) != -1) {
+		char *ptr;
+		char *input_name = strtok_r(line, " \t\r\n", &ptr);
+		if (input_name == NULL || input_name[0] == '#') continue;
+		char *output_name = strtok_r(NULL, " \t\r\n", &ptr);
+		char *option = strtok_r(NULL, " \t\r\n", &ptr);
+		if (output_name == NULL || option == NULL || strtok_r(NULL, " \t\r\n", &ptr) != NULL)
+			callError("Error: Invalid batch file format.");
+
+		if (batch.job_count == size) {
+			size = (size != 0) ? size * 2 : 64;
+			ss_Options_t *temp = (ss_Options_t *) realloc(batch.jobs, sizeof(ss_Options_t) * size);
+			if (temp == NULL) callError("Error: Memory could not be allocated.");
+			batch.jobs = temp;
+		}
+		ss_Options_t *job = &batch.jobs[batch.job_count++];
+		*job = *options;
+		job->input_name = strdup(input_name);
+		job->output_name = strdup(output_name);
+		job->option = atoi(option);
+		if (job->input_name == NULL || job->output_name == NULL) callError("Error: Memory could not be allocated.");
 	}
-	// Output file must end with a new line
-	// fprintf(output, "\n");
+	free(line);
+	fclose(manifest);
+
+	batch.results = (ss_Result_t *) calloc(batch.job_count + 1, sizeof(ss_Result_t));
+	if (batch.results == NULL) callError("Error: Memory could not be allocated.");
+	pthread_mutex_init(&batch.lock, NULL);
+
+	// The calling thread is one of the workers
+	int workers = (batch_jobs < batch.job_count) ? batch_jobs : batch.job_count;
+	pthread_t *threads = (pthread_t *) malloc(sizeof(pthread_t) * (workers + 1));
+	if (threads == NULL) callError("Error: Memory could not be allocated.");
+	for (int t = 1; t < workers; t++)
+		if (pthread_create(&threads[t], NULL, runWorker, &batch) != 0) callError("Error: Could not create thread.");
+	runWorker(&batch);
+	for (int t = 1; t < workers; t++) pthread_join(threads[t], NULL);
+
+	// Report each failed job, then a summary
+	int failed_count = 0;
+	for (int i = 0; i < batch.job_count; i++) {
+		ss_Result_t *result = &batch.results[i];
+		if (result->code == SS_RESULT_OK) continue;
+		if (result->line != 0)
+			printf("Batch: job %d (%s) failed at line %zu, column %zu.\n", i + 1, batch.jobs[i].input_name, result->line, result->column);
+		else
+			printf("Batch: job %d (%s) failed.\n", i + 1, batch.jobs[i].input_name);
+		failed_count++;
+	}
+	printf("Batch: %d of %d jobs succeeded.\n", batch.job_count - failed_count, batch.job_count);
 
-	// Close the output file
-	fclose(output);
+	for (int i = 0; i < batch.job_count; i++) {
+		free((char *) batch.jobs[i].input_name);
+		free((char *) batch.jobs[i].output_name);
+	}
+	pthread_mutex_destroy(&batch.lock);
+	free(batch.jobs);
+	free(batch.results);
+	free(threads);
 
-	printf("Successfully wrote to output file.\n");
-	printf("\n");
+	return failed_count == 0;
 }
 
 /**
  * Driver program.
  *
  * Usage:
- * 		./<name of executable> <input file> <output file> <option>
+ * 		./<name of executable> [flags] <input file> <output file> <option>
  *
  * Options as follows:
  * 		[1] Allow for sorting by just domestic students.
  * 		[2] Allow for sorting by just international students.
  * 		[3] Allow for sorting by all students.
+ * 		[4] Sort all students once and write options 1, 2 and 3 to
+ * 		    <output file>.1, <output file>.2 and <output file>.3.
+ *
+ * Flags as follows:
+ * 		--sort merge	Merge sort over a table of the sort fields (default).
+ * 		--sort radix	Radix sort on packed keys. Same output as merge.
+ * 		--sort natural	Merge the runs already in order. Fast on nearly sorted input.
+ * 		--sort parallel	Merge sort across threads. Same output as merge.
+ * 		--key <fields>	Sort by the comma separated fields, each with an optional
+ * 				":asc" or ":desc", from year, month, day, last, first, gpa,
+ * 				toefl and status. Fields left out follow in the default order.
+ * 				For example --key gpa:desc,last. Not used with --top or --memory.
+ * 		--threads <n>	Threads for --sort parallel, and for reading input files of a few
+ * 				megabytes or more. Defaults to the number of cores.
+ * 		--memory <mb>	Sort in chunks of about mb megabytes of students, spilling
+ * 				sorted runs to $TMPDIR and merging them. For inputs larger than memory.
+ * 		--top <n>	Write only the first n students in sort order. Keeps n students
+ * 				in memory while reading instead of the whole list.
+ * 		--snapshot <file>	Load the students from a binary snapshot of the input
+ * 				instead of reading it, if the snapshot was made from the same
+ * 				input file. Otherwise read the input and save the snapshot.
+ * 				Not used with --top or --memory.
+ * 		--cache <dir>	Keep outputs in dir by a hash of the input, option and --top.
+ * 				An input and option seen before is copied from there instead
+ * 				of sorted. Option 4 is not cached.
+ * 		--cache-size <mb>	Megabytes the cache may hold before the least
+ * 				recently used outputs are removed. Defaults to 1024.
+ * 		--batch <file>	Run every "<input file> <output file> <option>" line of the
+ * 				file in one process instead of the positional arguments.
+ * 		--jobs <n>	Batch jobs to run at once. Defaults to 1.
+ * 		--stats		Print the time of each phase, records per list, compares,
+ * 				allocations and bytes read and written as one line of JSON on
+ * 				stderr for each job. Also on if $STUDENTSORT_STATS is set and not 0.
+ *
+ * Build with CMake, which also builds libstudentsort and studentsort.h, or with
+ * 		cc -O3 -pthread -o studentsort a2.c studentsort.c
  *
  * Example input: 
  * 		"Mary Jackson Feb-2-1990 4.0 I 60"
@@ -654,52 +419,20 @@ int main(int argc, char *argv[]) {
 	}
 	fclose(outputFile);
 
-	// Check if number of arguments is valid. Then get inputs.
-	if (argc != 4) {
-		printf("Usage %s <input_file> <output_file> <option>\n", argv[0]);
-		callError("Error: Invalid number of arguments.");
-	}
-	const char *input_name = argv[1]; // Input file name
-	const char *output_name = argv[2]; // Output file name
-	error_output = output_name; // Set global error output
-	
-	// Open input file
-	FILE *file = fopen(input_name, "r");
-	if (file == NULL) callError("Error: Input file not found.");
-	fseek(file, 0, SEEK_SET); // Ensure cursor at start of file
-
-	// Check if option is valid
-	const int option = atoi(argv[3]);
-	if (option < 1 || option > 3) {
-		printf("Usage %s <input_file> <output_file> <option>\n", argv[0]);
-		callError("Error: Invalid option.");
-	}
+	ss_Options_t options;
+	parseArguments(argc, argv, &options);
+	if (stats_enabled) ss_collectStats(true); // Before any job starts, since jobs run on threads
+	if (batch_name != NULL) return runBatch(&options) ? 0 : 1;
 
-	// Setup linked list
-	ListNode_t *head = NULL;
-	StudentList_t *list = (StudentList_t *) malloc(sizeof(StudentList_t));
+	error_output = options.output_name; // Set global error output
+	ss_StudentList_t *list = (ss_StudentList_t *) calloc(1, sizeof(ss_StudentList_t));
 	if (list == NULL) callError("Error: Memory could not be allocated.");
 
-	// Read from input file
-	char encoding = 'U'; // Default encoding is UNIX. Function changes to Windows if needed.
-	readFile(file, list, option, &encoding);
-	switch (option) {
-		case 1: head = list->head_d; break; // Domestic
-		case 2: head = list->head_i; break; // International
-		case 3: head = list->head_a; break; // All
-	}
-	sortList(&head);
-	fclose(file);
-
-	// Write to output file
-	file = fopen(output_name, "w");
-	if (file == NULL) {
-		callError("Error: Output file could not open.");
-	}
-	writeFile(file, head, &encoding);
+	ss_Result_t result;
+	if (!runJob(&options, list, &result)) callError(result.message);
 
 	// Clean up
-	if (list->head_a != NULL) freeList(list->head_a);
+	ss_freeList(list);
 	free(list);
 
 	return 0;
@@ -0,0 +1,424 @@
+# include <stdio.h>
+# include <stdint.h>
+# include <stdlib.h>
+# include <stdbool.h>
+# include <string.h>
+# include <time.h>
+# include <sys/resource.h>
+# include "studentsort.h"
+
+// Create a struct for the benchmark arguments
+typedef struct BenchOptions {
+	size_t rows;
+	double international; // Fraction of rows that are international
+	double duplicates; // Fraction of rows that repeat an earlier row
+	double sorted; // Fraction of rows left in sort order, 0 for random order
+	uint64_t seed;
+	int option; // List to sort, same as the option argument of the program
+	const char *output_name; // File the write phase writes to
+	const char *save_name; // File to save the roster to, NULL to not save it
+	size_t index; // Students to insert into and remove from an index, 0 for no index phase
+	ss_Options_t sort; // Sort mode and threads
+} BenchOptions_t;
+
+// Create a struct for text being built in memory
+typedef struct Text {
+	char *data;
+	size_t length;
+	size_t size;
+} Text_t;
+
+// Earlier rows kept for duplicates
+#define RECENT_ROWS 4096
+
+// Months array
+const char *months[] = {
+	"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+	"Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+/**
+ * Function to call error.
+ * Prints error message and exits.
+ */
+void callError(const char *message) {
+	printf("%s\n", message);
+	exit(1);
+}
+
+/**
+ * Function to get the next random number, using xorshift64*.
+ */
+uint64_t nextRandom(uint64_t *state) {
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 2685821657736338717ULL;
+}
+
+/**
+ * Function to get a random number from 0 up to but not including limit.
+ */
+uint32_t randomBelow(uint64_t *state, uint32_t limit) {
+	return (uint32_t) ((nextRandom(state) >> 32) % limit);
+}
+
+/**
+ * Function to get a random fraction from 0 up to but not including 1.
+ */
+double randomFraction(uint64_t *state) {
+	return (double) (nextRandom(state) >> 11) / 9007199254740992.0;
+}
+
+/**
+ * Function to make room for length more bytes of text.
+ */
+void reserveText(Text_t *text, size_t length) {
+	if (text->length + length <= text->size) return;
+	size_t size = (text->size != 0) ? text->size * 2 : 1024 * 1024;
+	while (size < text->length + length) size *= 2;
+	char *temp = (char *) realloc(text->data, size);
+	if (temp == NULL) callError("Error: Memory could not be allocated.");
+	text->data = temp;
+	text->size = size;
+}
+
+/**
+ * Function to add a random name of 3 to 8 letters, capitalised.
+ */
+void addName(Text_t *text, uint64_t *state) {
+	int length = 3 + (int) randomBelow(state, 6);
+	for (int i = 0; i < length; i++) {
+		char letter = (char) ('a' + randomBelow(state, 26));
+		text->data[text->length++] = (i == 0) ? (char) (letter - 'a' + 'A') : letter;
+	}
+}
+
+/**
+ * Function to add one random valid student as a line of text.
+ * Every field passes the checks of readFile, addDate, addGPA and addTOEFL:
+ * no leading zeros, day 1 to 31, year 1950 to 2010, GPA 0.0 to 4.3 with at
+ * most five characters, and TOEFL 0 to 120 for international students only.
+ */
+void addStudent(Text_t *text, uint64_t *state, double international) {
+	reserveText(text, 64);
+	addName(text, state);
+	text->data[text->length++] = ' ';
+	addName(text, state);
+
+	int gpa = (int) randomBelow(state, 431); // Hundredths
+	text->length += (size_t) sprintf(text->data + text->length, " %s-%u-%u %d.%02d",
+		months[randomBelow(state, 12)], 1 + randomBelow(state, 31), 1950 + randomBelow(state, 61), gpa / 100, gpa % 100);
+
+	if (randomFraction(state) < international)
+		text->length += (size_t) sprintf(text->data + text->length, " I %u\n", randomBelow(state, 121));
+	else
+		text->length += (size_t) sprintf(text->data + text->length, " D\n");
+}
+
+/**
+ * Function to generate a roster of random valid students.
+ * Some rows repeat one of the recent rows, so their keys tie.
+ */
+Text_t generateRoster(const BenchOptions_t *options) {
+	Text_t text = {NULL, 0, 0};
+	uint64_t state = options->seed * 2654435761ULL + 1;
+	size_t recent[RECENT_ROWS];
+	size_t recent_count = 0;
+
+	for (size_t row = 0; row < options->rows; row++) {
+		size_t start = text.length;
+		if (recent_count > 0 && randomFraction(&state) < options->duplicates) {
+			// Copy a recent row, which ends at the next newline
+			size_t from = recent[randomBelow(&state, (uint32_t) recent_count)];
+			size_t length = (size_t) ((char *) memchr(text.data + from, '\n', text.length - from) - (text.data + from)) + 1;
+			reserveText(&text, length);
+			memcpy(text.data + text.length, text.data + from, length);
+			text.length += length;
+		} else {
+			addStudent(&text, &state, options->international);
+		}
+
+		if (recent_count < RECENT_ROWS) recent[recent_count++] = start;
+		else recent[randomBelow(&state, RECENT_ROWS)] = start;
+	}
+	return text;
+}
+
+/**
+ * Function to put a fraction of a roster in sort order.
+ * Sorts every row, then moves each row with chance 1 - sorted to a random place.
+ */
+Text_t presortRoster(Text_t roster, const BenchOptions_t *options) {
+	ss_StudentList_t list;
+	memset(&list, 0, sizeof(list));
+	ss_Result_t result;
+	char encoding;
+	if (!ss_parseBuffer(roster.data, roster.length, &list, &encoding, &result)) callError(result.message);
+
+	ss_ListNode_t *head = list.head_a;
+	ss_sortList(&head);
+
+	ss_ListNode_t **nodes = (ss_ListNode_t **) malloc(sizeof(ss_ListNode_t *) * (options->rows + 1));
+	if (nodes == NULL) callError("Error: Memory could not be allocated.");
+	size_t count = 0;
+	for (ss_ListNode_t *current = head; current != NULL; current = current->next) nodes[count++] = current;
+
+	uint64_t state = options->seed * 40503ULL + 7;
+	for (size_t i = 0; i < count; i++) {
+		if (randomFraction(&state) < options->sorted) continue;
+		size_t j = (size_t) (randomFraction(&state) * (double) count);
+		ss_ListNode_t *swap = nodes[i];
+		nodes[i] = nodes[j];
+		nodes[j] = swap;
+	}
+	for (size_t i = 0; i + 1 < count; i++) nodes[i]->next = nodes[i + 1];
+	if (count > 0) nodes[count - 1]->next = NULL;
+
+	Text_t text = {NULL, 0, 0};
+	text.data = ss_serializeList((count > 0) ? nodes[0] : NULL, &encoding, &text.length, &result);
+	if (text.data == NULL) callError(result.message);
+	text.size = text.length;
+
+	free(nodes);
+	ss_freeList(&list);
+	free(roster.data);
+	return text;
+}
+
+/**
+ * Function to get the time in seconds from a steady clock.
+ */
+double now() {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
+
+/**
+ * Function to get the peak resident memory of the process in megabytes.
+ */
+double peakMegabytes() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (double) usage.ru_maxrss / 1024.0; // ru_maxrss is in kilobytes on Linux
+}
+
+/**
+ * Function to print the time of one phase.
+ */
+void reportPhase(const char *phase, double seconds, size_t records) {
+	printf("%-6s seconds=%.3f records/s=%.0f peak_rss_mb=%.1f\n",
+		phase, seconds, (seconds > 0) ? (double) records / seconds : 0.0, peakMegabytes());
+}
+
+/**
+ * Function to time an index of a list and check it against a full sort.
+ * Loads every student of the list, inserts the students of a second roster
+ * of options->index rows, then removes the first options->index students of
+ * the list. The index must then match ss_sortList on the students it should
+ * have. The list itself must not be changed by the index.
+ */
+void benchIndex(ss_StudentList_t *list, const BenchOptions_t *options) {
+	BenchOptions_t extra_options = *options;
+	extra_options.rows = options->index;
+	extra_options.seed = options->seed + 1;
+	Text_t extra_roster = generateRoster(&extra_options);
+	ss_StudentList_t extra;
+	memset(&extra, 0, sizeof(extra));
+	ss_Result_t result;
+	char encoding;
+	if (!ss_parseBuffer(extra_roster.data, extra_roster.length, &extra, &encoding, &result)) callError(result.message);
+
+	double start = now();
+	ss_StudentIndex_t *index = ss_createIndex(list, &result);
+	if (index == NULL) callError(result.message);
+	reportPhase("load", now() - start, ss_indexCount(index));
+	ss_ListNode_t *last = list->head_a;
+	while (last != NULL && last->next != NULL) last = last->next;
+	if (last != list->tail_a) callError("Error: Loading the index changed the list.");
+
+	start = now();
+	for (ss_ListNode_t *current = extra.head_a; current != NULL; current = current->next)
+		if (!ss_insertStudent(index, current->student, &result)) callError(result.message);
+	reportPhase("insert", now() - start, options->index);
+
+	start = now();
+	ss_ListNode_t *kept = list->head_a;
+	size_t removed = 0;
+	for (; kept != NULL && removed < options->index; kept = kept->next, removed++)
+		if (!ss_removeStudent(index, kept->student)) callError("Error: Indexed student was not found.");
+	reportPhase("remove", now() - start, removed);
+
+	// Sort copies of the students that should be left, kept ones first
+	size_t count = 0;
+	for (ss_ListNode_t *current = kept; current != NULL; current = current->next) count++;
+	for (ss_ListNode_t *current = extra.head_a; current != NULL; current = current->next) count++;
+	ss_ListNode_t *nodes = (ss_ListNode_t *) malloc(sizeof(ss_ListNode_t) * (count + 1));
+	if (nodes == NULL) callError("Error: Memory could not be allocated.");
+	size_t i = 0;
+	for (ss_ListNode_t *current = kept; current != NULL; current = current->next) nodes[i++].student = current->student;
+	for (ss_ListNode_t *current = extra.head_a; current != NULL; current = current->next) nodes[i++].student = current->student;
+	for (i = 0; i < count; i++) nodes[i].next = (i + 1 < count) ? &nodes[i + 1] : NULL;
+	ss_ListNode_t *expected = (count > 0) ? nodes : NULL;
+	ss_sortList(&expected);
+
+	if (ss_indexCount(index) != count) callError("Error: Index holds the wrong number of students.");
+	ss_ListNode_t *actual = ss_indexList(index);
+	for (; expected != NULL && actual != NULL; expected = expected->next, actual = actual->next)
+		if (ss_compareStudents(expected->student, actual->student) != 0) break;
+	if (expected != NULL || actual != NULL) callError("Error: Index order does not match a full sort.");
+	printf("index  check=ok students=%zu\n", count);
+
+	free(nodes);
+	ss_freeIndex(index);
+	ss_freeList(&extra);
+	free(extra_roster.data);
+}
+
+/**
+ * Function to print the usage of the benchmark.
+ */
+void printUsage(const char *program) {
+	printf("Usage %s [--rows <count>] [--international <fraction>] [--duplicates <fraction>] "
+		"[--sorted <fraction>] [--seed <number>] [--option 1|2|3] [--sort merge|radix|natural|parallel] "
+		"[--threads <count>] [--output <file>] [--save <file>] [--index <count>]\n", program);
+}
+
+/**
+ * Function to read a fraction from 0 to 1.
+ */
+double parseFraction(const char *text, const char *program) {
+	char *end;
+	double value = strtod(text, &end);
+	if (*end != '\0' || !(value >= 0.0 && value <= 1.0)) {
+		printUsage(program);
+		callError("Error: Invalid fraction.");
+	}
+	return value;
+}
+
+/**
+ * Function to read the command line arguments into options.
+ */
+void parseArguments(int argc, char *argv[], BenchOptions_t *options) {
+	options->rows = 1000000;
+	options->international = 0.5;
+	options->duplicates = 0.0;
+	options->sorted = 0.0;
+	options->seed = 2510;
+	options->option = 3;
+	options->output_name = "/dev/null";
+	options->save_name = NULL;
+	options->index = 0;
+	ss_initOptions(&options->sort);
+
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 >= argc) {
+			printUsage(argv[0]);
+			callError("Error: Invalid flag.");
+		}
+		if (strcmp(argv[i], "--rows") == 0) {
+			long long rows = atoll(argv[++i]);
+			if (rows < 1) callError("Error: Invalid number of rows.");
+			options->rows = (size_t) rows;
+		} else if (strcmp(argv[i], "--international") == 0) {
+			options->international = parseFraction(argv[++i], argv[0]);
+		} else if (strcmp(argv[i], "--duplicates") == 0) {
+			options->duplicates = parseFraction(argv[++i], argv[0]);
+		} else if (strcmp(argv[i], "--sorted") == 0) {
+			options->sorted = parseFraction(argv[++i], argv[0]);
+		} else if (strcmp(argv[i], "--seed") == 0) {
+			options->seed = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--option") == 0) {
+			options->option = atoi(argv[++i]);
+			if (options->option < 1 || options->option > 3) callError("Error: Invalid option.");
+		} else if (strcmp(argv[i], "--sort") == 0) {
+			i++;
+			if (strcmp(argv[i], "merge") == 0) options->sort.sort_mode = SS_SORT_MERGE;
+			else if (strcmp(argv[i], "radix") == 0) options->sort.sort_mode = SS_SORT_RADIX;
+			else if (strcmp(argv[i], "natural") == 0) options->sort.sort_mode = SS_SORT_NATURAL;
+			else if (strcmp(argv[i], "parallel") == 0) options->sort.sort_mode = SS_SORT_PARALLEL;
+			else callError("Error: Invalid sort mode.");
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			options->sort.threads = atoi(argv[++i]);
+			if (options->sort.threads < 1 || options->sort.threads > 1024) callError("Error: Invalid number of threads.");
+		} else if (strcmp(argv[i], "--output") == 0) {
+			options->output_name = argv[++i];
+		} else if (strcmp(argv[i], "--save") == 0) {
+			options->save_name = argv[++i];
+		} else if (strcmp(argv[i], "--index") == 0) {
+			long long index = atoll(argv[++i]);
+			if (index < 1) callError("Error: Invalid number of index rows.");
+			options->index = (size_t) index;
+		} else {
+			printUsage(argv[0]);
+			callError("Error: Invalid flag.");
+		}
+	}
+}
+
+/**
+ * Benchmark of the parse, sort and write phases of the library.
+ *
+ * Generates a roster of valid students in memory, then times each phase on
+ * its own: ss_parseBuffer, which is the readFile of the program on mapped
+ * input, ss_sortStudents, and ss_writeFile. Prints seconds, records per second
+ * and the peak resident memory so far after each phase. With --index, also
+ * times an index of the roster before the sort and checks it against ss_sortList.
+ *
+ * Flags as follows:
+ * 		--rows <n>		Students in the roster. Defaults to 1000000.
+ * 		--international <f>	Fraction of international students. Defaults to 0.5.
+ * 		--duplicates <f>	Fraction of rows that repeat a recent row. Defaults to 0.
+ * 		--sorted <f>		Fraction of rows already in sort order. Defaults to 0.
+ * 		--seed <n>		Seed of the generator, the same seed gives the same roster.
+ * 		--option <n>		List to sort and write, as in the program. Defaults to 3.
+ * 		--sort, --threads	Sort mode and threads, as in the program.
+ * 		--output <file>		File written by the write phase. Defaults to /dev/null.
+ * 		--save <file>		Also save the roster, to run the program on it.
+ * 		--index <n>		Rows to insert into and remove from an index. Defaults to 0, no index.
+ */
+int main(int argc, char *argv[]) {
+	BenchOptions_t options;
+	parseArguments(argc, argv, &options);
+	const char *sort_names[] = {"merge", "radix", "natural", "parallel"};
+
+	Text_t roster = generateRoster(&options);
+	if (options.sorted > 0.0) roster = presortRoster(roster, &options);
+	if (options.save_name != NULL) {
+		FILE *file = fopen(options.save_name, "w");
+		if (file == NULL || fwrite(roster.data, 1, roster.length, file) != roster.length) callError("Error: Could not save roster.");
+		fclose(file);
+	}
+	printf("rows=%zu international=%.2f duplicates=%.2f sorted=%.2f option=%d sort=%s threads=%d bytes=%zu\n",
+		options.rows, options.international, options.duplicates, options.sorted, options.option,
+		sort_names[options.sort.sort_mode], options.sort.threads, roster.length);
+
+	ss_StudentList_t list;
+	memset(&list, 0, sizeof(list));
+	ss_Result_t result;
+	char encoding;
+
+	double start = now();
+	if (!ss_parseBuffer(roster.data, roster.length, &list, &encoding, &result)) callError(result.message);
+	reportPhase("parse", now() - start, options.rows);
+	if (options.index > 0) benchIndex(&list, &options);
+
+	ss_ListNode_t *head = ss_selectList(&list, options.option);
+	size_t records = 0;
+	for (ss_ListNode_t *current = head; current != NULL; current = current->next) records++;
+	start = now();
+	ss_sortStudents(&head, &options.sort);
+	reportPhase("sort", now() - start, records);
+
+	FILE *output = fopen(options.output_name, "w");
+	if (output == NULL) callError("Error: Output file could not open.");
+	start = now();
+	if (!ss_writeFile(output, head, &encoding, &result)) callError(result.message);
+	reportPhase("write", now() - start, records);
+
+	ss_freeList(&list);
+	free(roster.data);
+	return 0;
+}
@@ -0,0 +1,44 @@
+#!/bin/sh
+# Scaling benchmark for --sort parallel.
+#
+# Usage:
+# 		bench/scaling.sh [rows]
+#
+# Builds the program, generates a roster of random valid students, then sorts
+# all students with 1, 2, 4, 8 and 16 threads. Since --threads also splits the
+# parse, the read and sort phases are reported on their own from --stats, and
+# the write is left out. Every run is checked against the output of the default
+# merge sort.
+
+ROWS=${1:-2000000}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cc -O3 -pthread -o "$DIR/a2" "$(dirname "$0")/../a2.c" "$(dirname "$0")/../studentsort.c" || exit 1
+
+awk -v rows="$ROWS" 'BEGIN {
+	srand(2510);
+	split("Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec", months, " ");
+	for (i = 0; i < rows; i++) {
+		first = ""; last = "";
+		for (j = 0; j < 5; j++) first = first sprintf("%c", 97 + int(rand() * 26));
+		for (j = 0; j < 6; j++) last = last sprintf("%c", 97 + int(rand() * 26));
+		printf "%s %s %s-%d-%d %d.%d ", first, last, months[1 + int(rand() * 12)],
+			1 + int(rand() * 31), 1950 + int(rand() * 61), int(rand() * 4), int(rand() * 10);
+		if (rand() < 0.5) printf "D\n";
+		else printf "I %d\n", int(rand() * 121);
+	}
+	printf "\n";
+}' > "$DIR/input.txt"
+
+cd "$DIR" || exit 1
+./a2 input.txt expected.txt 3 > /dev/null || exit 1
+
+echo "rows=$ROWS"
+for THREADS in 1 2 4 8 16; do
+	./a2 --stats --sort parallel --threads "$THREADS" input.txt output.txt 3 > /dev/null 2> stats.txt || exit 1
+	READ=$(sed -n 's/.*"read":\([0-9.]*\).*/\1/p' stats.txt)
+	SORT=$(sed -n 's/.*"sort":\([0-9.]*\).*/\1/p' stats.txt)
+	if cmp -s expected.txt output.txt; then RESULT=ok; else RESULT=MISMATCH; fi
+	echo "$THREADS $READ $SORT $RESULT" | awk '{ printf "threads=%-2d read=%.3f sort=%.3f %s\n", $1, $2, $3, $4 }'
+done
@@ -0,0 +1,4222 @@
+# include <stdio.h>
+# include <stdint.h>
+# include <stdlib.h>
+# include <stdbool.h>
+# include <string.h>
+# include <ctype.h>
+# include <pthread.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <dirent.h>
+# include <sys/ioctl.h>
+# include <errno.h>
+# include <time.h>
+# include "studentsort.h"
+
+// Vector scanners for x86-64, picked at run time. Other targets scan byte by byte.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+# define SCAN_X86
+# include <immintrin.h>
+#endif
+
+// Reflinks for copying cached output, where the file system has them
+#ifdef __linux__
+# include <linux/fs.h>
+#endif
+
+// Create a struct for one block of memory in an arena
+typedef struct ss_ArenaBlock {
+	struct ss_ArenaBlock *next; // Previous block, freed along with this one
+	size_t size;
+	size_t used;
+	char data[];
+} ArenaBlock_t;
+
+// Create a struct to return to an earlier point of an arena
+typedef struct ArenaMark {
+	ArenaBlock_t *block;
+	size_t used;
+} ArenaMark_t;
+
+// Create a struct for a student kept by --top, with its own copy of the text
+typedef struct TopEntry {
+	ss_Student_t student;
+	uint64_t sequence; // Input order, breaks ties so the result is stable
+	char *text;
+	size_t text_size;
+} TopEntry_t;
+
+// Create a struct for the first students in sort order seen while reading.
+// A max heap, so the student that would be dropped next is on top.
+typedef struct ss_TopList {
+	TopEntry_t *entries; // Grown as students are offered, up to limit
+	size_t *heap; // Indices into entries
+	size_t count;
+	size_t capacity; // Entries allocated
+	size_t limit;
+	int option; // Which students to keep, same as the option argument
+	uint64_t sequence; // Students offered so far
+} TopList_t;
+
+// Create a struct for one student of an index.
+// The list node comes first, so level 0 of the index is a sorted ss_ListNode_t list.
+typedef struct IndexNode {
+	ss_ListNode_t node;
+	bool owned; // Allocated by ss_insertStudent with a copy of the student, else in the arena
+	uint8_t height; // Levels the node is on
+	struct IndexNode *forward[]; // Next node on levels 1 to height - 1
+} IndexNode_t;
+
+// Tallest an index node can be. Each level holds about a quarter of the one below.
+#define INDEX_MAX_HEIGHT 16
+
+// Skip list of students in sort order
+struct ss_StudentIndex {
+	IndexNode_t *head; // No student, INDEX_MAX_HEIGHT levels tall
+	ss_Arena_t arena; // Head and the nodes loaded by ss_createIndex
+	size_t count;
+	int height; // Levels in use
+	uint64_t random; // State for randomHeight
+};
+
+// Months array
+static const char *months[] = {
+	"Jan", "Feb", "Mar", "Apr", "May", "Jun", 
+	"Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+// Index into months by the sum of the last two letters of a month, masked to
+// 5 bits. No two months share a sum, so a month is found with one lookup.
+static const uint8_t month_hash[32] = {
+	SS_MONTH_NONE, 6, 3, 5, SS_MONTH_NONE, 10, SS_MONTH_NONE, 1,
+	11, SS_MONTH_NONE, SS_MONTH_NONE, SS_MONTH_NONE, SS_MONTH_NONE, SS_MONTH_NONE, SS_MONTH_NONE, 0,
+	SS_MONTH_NONE, SS_MONTH_NONE, SS_MONTH_NONE, 2, SS_MONTH_NONE, 8, SS_MONTH_NONE, 9,
+	SS_MONTH_NONE, SS_MONTH_NONE, 4, SS_MONTH_NONE, 7, SS_MONTH_NONE, SS_MONTH_NONE, SS_MONTH_NONE
+};
+
+// Arena blocks start small and double up to the largest size
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_MAX_BLOCK_SIZE (64 * 1024 * 1024)
+
+// Create a struct for a sorted run of the linked list
+typedef struct Run {
+	ss_ListNode_t *head;
+	ss_ListNode_t *tail; // Last node, its next is NULL
+	size_t length;
+} Run_t;
+
+// Most pending runs of the natural merge sort. Run lengths grow at least
+// like Fibonacci numbers, so this covers any list that fits in memory.
+#define MAX_RUNS 128
+
+// Create a struct for the work done by one thread, read by ss_sortFile for stats
+typedef struct Counters {
+	uint64_t compares; // Compares and allocations are only counted while collect_stats is set
+	uint64_t allocations;
+	uint64_t bytes_written;
+} Counters_t;
+
+// Create a struct for one thread of the parallel sort.
+// Sorts a part in place, or merges slices of two sorted parts into out.
+typedef struct SortTask {
+	Counters_t work; // Work done by the task, first so runTasks can find it
+	ss_ListNode_t **left;
+	size_t left_length;
+	ss_ListNode_t **right;
+	size_t right_length;
+	ss_ListNode_t **out;
+	size_t out_begin; // Slice of the merged output this task writes
+	size_t out_end;
+} SortTask_t;
+
+// Fewest nodes per thread before the parallel sort uses fewer threads
+#define PARALLEL_GRAIN 4096
+
+// Create a struct for the input file, either a stream or mapped memory
+typedef struct Input {
+	FILE *file; // Read with fgetc when data is NULL
+	const char *data; // Mapped contents of the file
+	size_t length;
+	size_t position;
+	size_t characters; // Characters read so far, kept between chunks
+	size_t lines; // Lines read so far, kept between chunks
+	char *buffer; // Word being read, kept between chunks and freed by closeInput
+	int buffer_size;
+} Input_t;
+
+// Create a struct for one chunk of the input, read on its own thread
+typedef struct ParseTask {
+	Counters_t work; // Work done by the task, first so runTasks can find it
+	Input_t input; // The chunk, read as mapped input of its own
+	ss_StudentList_t list; // Students of the chunk. Names hold ids of its own name table.
+	int option;
+	char encoding;
+	bool read; // Whether the whole chunk was read
+	ss_Result_t result;
+} ParseTask_t;
+
+// Fewest bytes of input per thread before reading with fewer threads.
+// The parse test defines a smaller one, so short rosters are read in chunks.
+#ifndef PARSE_GRAIN
+# define PARSE_GRAIN (1024 * 1024)
+#endif
+
+// Bytes of input classified at once by the scanner
+#define SCAN_BLOCK 32
+
+// Create a struct for the classes of the bytes of a block, one bit per byte
+typedef struct BlockMasks {
+	uint32_t newlines; // '\n'
+	uint32_t spaces; // ' '
+	uint32_t others; // Other space, control or non-ASCII bytes, which need the slow path
+} BlockMasks_t;
+
+// Create a struct for the layout of a line found by scanLine
+typedef struct LineScan {
+	size_t length; // Bytes before the '\n'
+	bool found; // Whether a '\n' ends the line before the end of the input
+	int spaces; // Spaces in the line
+	uint32_t space_at[6]; // Offsets of the first spaces
+	int others; // Other bytes, see BlockMasks_t
+	size_t other_at; // Offset of the first other byte
+} LineScan_t;
+
+// Create a struct for the header of a student spilled to a run file.
+// The text of each present field follows the header.
+typedef struct SpillHeader {
+	uint32_t lengths[8]; // Field lengths in ss_Student_t order, SPILL_MISSING if missing
+	uint16_t year_value;
+	uint16_t gpa_value;
+	uint8_t month_index;
+	uint8_t day_value;
+	uint8_t toefl_value;
+	uint8_t status_value;
+} SpillHeader_t;
+
+// Create a struct for a sorted run spilled to a temporary file
+typedef struct SpillFile {
+	FILE *file;
+	ss_Student_t student; // Current student of the run
+	char *text; // Holds the fields of the current student
+	size_t text_size;
+} SpillFile_t;
+
+#define SPILL_MISSING UINT32_MAX
+
+// Create a struct for the start of a snapshot file, the students of an input
+// file already read and checked. Columns of each field follow, one value per
+// student, then the text of every field. Native byte order.
+typedef struct SnapshotHeader {
+	char magic[8]; // SNAPSHOT_MAGIC
+	uint32_t version; // SNAPSHOT_VERSION
+	uint32_t header_size; // So a different layout of this struct is not read
+	uint64_t checksum; // Of everything after the header
+	uint64_t input_size; // Size, modification time and file of the input it was made from
+	int64_t input_seconds;
+	int64_t input_nanoseconds;
+	uint64_t input_inode;
+	uint64_t input_device;
+	uint64_t count; // Students
+	uint64_t text_length; // Bytes of text
+	char encoding; // Of the input, 'U' or 'W'
+	uint8_t sorted; // 1 if the students are in sort order
+	uint8_t padding[6];
+} SnapshotHeader_t;
+
+// Create a struct for the offset of each column of a snapshot file
+typedef struct SnapshotLayout {
+	size_t years; // uint16_t year_value
+	size_t gpas; // uint16_t gpa_value
+	size_t months; // uint8_t month_index
+	size_t days; // uint8_t day_value
+	size_t toefls; // uint8_t toefl_value
+	size_t statuses; // uint8_t status_value
+	size_t last_ranks; // uint32_t last_rank
+	size_t first_ranks; // uint32_t first_rank
+	size_t offsets; // uint64_t start of the text of the student
+	size_t lengths; // uint32_t length of each field in ss_Student_t order, SPILL_MISSING if missing
+	size_t text;
+	size_t size; // Of the whole file
+} SnapshotLayout_t;
+
+// Hex digits of a cache key and its '\0'
+#define CACHE_KEY_SIZE 33
+// Part of every cache key, changed when the output for the same input changes
+#define CACHE_VERSION 1
+
+#define SNAPSHOT_MAGIC "STUSNAP\0"
+#define SNAPSHOT_VERSION 1
+
+// Create a struct for one output file in the result cache
+typedef struct CacheEntry {
+	char key[CACHE_KEY_SIZE]; // Also the file name
+	uint64_t size;
+	int64_t used_seconds; // Modification time, set again on every hit
+	int64_t used_nanoseconds;
+} CacheEntry_t;
+
+// Create a struct for buffered output written with write(2)
+typedef struct Writer {
+	int fd; // -1 to keep everything in the buffer instead
+	char *buffer;
+	size_t length; // Bytes waiting to be written
+	size_t size;
+} Writer_t;
+
+// Size of the output buffer, flushed in blocks of this size
+#define WRITE_BUFFER_SIZE (1024 * 1024)
+
+// Create a struct to intern names and rank them in strcmp order.
+// Each distinct name gets an id in the order it was first seen.
+typedef struct ss_NameTable {
+	uint64_t *slots; // Hash of the name in the high half and id + 1 in the low half, 0 if empty
+	size_t size; // Number of slots, always a power of two
+	ss_Slice_t *names; // Distinct names by id
+	uint32_t *ranks; // Rank of each name by id, set by rankNames
+	uint32_t *order; // Ids in rank order, set by rankNames
+	size_t count; // Number of distinct names
+	size_t capacity; // Names the arrays can hold
+	bool ranked; // Whether the students of the list hold ranks rather than ids
+} NameTable_t;
+
+// Create a struct for a name being ranked
+typedef struct RankedName {
+	uint64_t prefix; // First 8 bytes, big endian, so most names compare without their text
+	ss_Slice_t name;
+	uint32_t id;
+} RankedName_t;
+
+// Create a struct for one record of the radix sort
+typedef struct SortItem {
+	uint64_t key; // Packed non-name fields, see studentKey, or the high half of an encoded key
+	uint64_t name; // Packed last and first name ranks, or the low half of an encoded key
+	ss_ListNode_t *node;
+} SortItem_t;
+
+// Create a struct for the sort fields of a list, one array per field, so a
+// compare reads three small arrays instead of two nodes and their students
+typedef struct StudentTable {
+	uint16_t *date; // Year, month and day, the high part of studentKey
+	uint64_t *name; // Last name rank above first name rank
+	uint32_t *rest; // GPA, TOEFL and status, the low part of studentKey
+	ss_ListNode_t **nodes; // Node of each row, in list order
+	size_t count;
+	int name_bits; // Bits of name in use
+} StudentTable_t;
+
+// Rows sorted by insertion before the table sort starts merging
+#define TABLE_RUN 16
+
+// Work done by the calling thread
+static _Thread_local Counters_t counters;
+
+// Whether phases are timed and compares and allocations counted, off unless stats are wanted
+static bool collect_stats;
+
+// Last id given to a set of name ranks, see nextRankSet
+static uint32_t rank_sets;
+
+// Bit layout of SortItem_t key. Name ranks sort between the two parts.
+#define KEY_LOW_BITS 26 // GPA, TOEFL and status
+#define KEY_DATE_SHIFT 32 // Year, month and day
+#define KEY_DATE_BITS 16
+
+/**
+ * Function to fill in the result of an error.
+ * Returns false so a failing function can return it directly.
+ */
+static bool setError(ss_Result_t *result, ss_ResultCode_t code, const char *message) {
+	result->code = code;
+	result->message = message;
+	result->line = 0;
+	result->column = 0;
+	return false;
+}
+
+/**
+ * Function to fill in the result of an error in the input file.
+ * Returns false so a failing function can return it directly.
+ */
+static bool setInputError(ss_Result_t *result, const char *message, size_t line, size_t column) {
+	setError(result, SS_RESULT_INVALID_INPUT, message);
+	result->line = line;
+	result->column = column;
+	return false;
+}
+
+/**
+ * Function to allocate memory with malloc and count the allocation.
+ */
+static void *allocate(size_t size) {
+	if (collect_stats) counters.allocations++;
+	return malloc(size);
+}
+
+/**
+ * Function to allocate zeroed memory with calloc and count the allocation.
+ */
+static void *allocateZeroed(size_t count, size_t size) {
+	if (collect_stats) counters.allocations++;
+	return calloc(count, size);
+}
+
+/**
+ * Function to resize memory with realloc and count the allocation.
+ */
+static void *reallocate(void *memory, size_t size) {
+	if (collect_stats) counters.allocations++;
+	return realloc(memory, size);
+}
+
+/**
+ * Function to allocate memory from an arena.
+ * Bumps a pointer in the current block and starts a new block when full.
+ * Returns NULL if a new block could not be allocated.
+ */
+static void *arenaAlloc(ss_Arena_t *arena, size_t size, size_t align) {
+	ArenaBlock_t *block = arena->block;
+
+	if (block != NULL) {
+		size_t start = (block->used + align - 1) & ~(align - 1);
+		if (start + size <= block->size) {
+			block->used = start + size;
+			return block->data + start;
+		}
+	}
+
+	// Start a new block, big enough for the request
+	size_t block_size = (arena->next_size != 0) ? arena->next_size : ARENA_BLOCK_SIZE;
+	if (block_size < ARENA_MAX_BLOCK_SIZE) arena->next_size = block_size * 2;
+	if (block_size < size + align) block_size = size + align;
+
+	ArenaBlock_t *new_block = (ArenaBlock_t *) allocate(sizeof(ArenaBlock_t) + block_size);
+	if (new_block == NULL) return NULL;
+	new_block->next = block;
+	new_block->size = block_size;
+	new_block->used = 0;
+	arena->block = new_block;
+	arena->allocated += block_size;
+
+	return arenaAlloc(arena, size, align);
+}
+
+/**
+ * Function to copy text into an arena.
+ * Returns NULL if memory could not be allocated.
+ */
+static const char *arenaCopy(ss_Arena_t *arena, const char *text, size_t length) {
+	char *copy = (char *) arenaAlloc(arena, length, 1);
+	if (copy == NULL) return NULL;
+	memcpy(copy, text, length);
+	return copy;
+}
+
+/**
+ * Function to free every block of an arena.
+ */
+static void freeArena(ss_Arena_t *arena) {
+	ArenaBlock_t *block = arena->block;
+	while (block != NULL) {
+		ArenaBlock_t *temp = block;
+		block = block->next;
+		free(temp);
+	}
+	arena->block = NULL;
+	arena->next_size = 0;
+	arena->allocated = 0;
+}
+
+/**
+ * Function to empty an arena but keep its newest, largest block.
+ * Lets the next job reuse the memory without asking malloc again.
+ */
+static void clearArena(ss_Arena_t *arena) {
+	ArenaBlock_t *block = arena->block;
+	if (block == NULL) return;
+
+	ArenaBlock_t *older = block->next;
+	while (older != NULL) {
+		ArenaBlock_t *temp = older;
+		older = older->next;
+		free(temp);
+	}
+	block->next = NULL;
+	block->used = 0;
+	arena->allocated = block->size;
+}
+
+/**
+ * Function to remember the current point of an arena.
+ */
+static ArenaMark_t markArena(ss_Arena_t *arena) {
+	ArenaMark_t mark = {arena->block, (arena->block != NULL) ? arena->block->used : 0};
+	return mark;
+}
+
+/**
+ * Function to free everything allocated from an arena since the mark.
+ */
+static void releaseArena(ss_Arena_t *arena, ArenaMark_t mark) {
+	while (arena->block != mark.block) {
+		ArenaBlock_t *temp = arena->block;
+		arena->block = temp->next;
+		arena->allocated -= temp->size;
+		free(temp);
+	}
+	if (arena->block != NULL) arena->block->used = mark.used;
+}
+
+/**
+ * Function to move every block of part into an arena.
+ * The blocks go behind the current block, which keeps being filled. Part is left empty.
+ */
+static void spliceArena(ss_Arena_t *arena, ss_Arena_t *part) {
+	if (part->block == NULL) return;
+
+	if (arena->block == NULL) {
+		*arena = *part;
+	} else {
+		ArenaBlock_t *last = part->block;
+		while (last->next != NULL) last = last->next;
+		last->next = arena->block->next;
+		arena->block->next = part->block;
+		arena->allocated += part->allocated;
+	}
+	part->block = NULL;
+	part->next_size = 0;
+	part->allocated = 0;
+}
+
+/**
+ * Function to set every field of a node to missing.
+ */
+static void resetNode(ss_Student_t *node) {
+	ss_Slice_t missing = {NULL, 0};
+	node->first_name = missing;
+	node->last_name = missing;
+	node->birth_month = missing;
+	node->birth_day = missing;
+	node->birth_year = missing;
+	node->gpa = missing;
+	node->status = missing;
+	node->toefl = missing;
+
+	node->year_value = SS_YEAR_NONE;
+	node->gpa_value = SS_GPA_NONE;
+	node->month_index = SS_MONTH_NONE;
+	node->day_value = SS_DAY_NONE;
+	node->toefl_value = SS_TOEFL_NONE;
+	node->status_value = SS_STATUS_NONE;
+	node->last_rank = SS_RANK_NONE;
+	node->first_rank = SS_RANK_NONE;
+	node->rank_set = 0;
+}
+
+/**
+ * Function to create a node.
+ * Allocates the node from the arena of the list.
+ * Returns NULL if memory could not be allocated.
+ */
+static ss_Student_t *createNode(ss_StudentList_t *list) {
+	ss_Student_t *node = (ss_Student_t *) arenaAlloc(&list->arena, sizeof(ss_Student_t), _Alignof(ss_Student_t));
+	if (node == NULL) return NULL;
+	resetNode(node);
+	return node;
+}
+
+/**
+ * Function to make a slice of text.
+ */
+static ss_Slice_t makeSlice(const char *text, size_t length) {
+	ss_Slice_t slice = {text, (uint32_t) length};
+	return slice;
+}
+
+/**
+ * Function to compare two slices.
+ * Same order as strcmp on the text.
+ */
+static int compareSlices(ss_Slice_t a, ss_Slice_t b) {
+	uint32_t length = (a.length < b.length) ? a.length : b.length;
+	int result = memcmp(a.text, b.text, length);
+	if (result != 0) return result;
+
+	// Shorter text is a prefix of the longer one, so it comes first
+	if (a.length < b.length) return -1;
+	if (a.length > b.length) return 1;
+	return 0;
+}
+
+/**
+ * Function to hash a name using FNV-1a.
+ */
+static uint64_t hashName(ss_Slice_t name) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (uint32_t i = 0; i < name.length; i++) {
+		hash ^= (unsigned char) name.text[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/**
+ * Function to setup an empty name table.
+ * Size is rounded up to a power of two. The table grows past expected names.
+ * Returns false if memory could not be allocated.
+ */
+static bool initNameTable(NameTable_t *table, size_t expected) {
+	table->size = 16;
+	while (table->size < expected * 2) table->size *= 2;
+	table->capacity = table->size / 2;
+	table->count = 0;
+	table->ranked = false;
+	table->slots = (uint64_t *) allocateZeroed(table->size, sizeof(uint64_t));
+	table->names = (ss_Slice_t *) allocate(sizeof(ss_Slice_t) * table->capacity);
+	table->ranks = NULL;
+	table->order = NULL;
+	return table->slots != NULL && table->names != NULL;
+}
+
+/**
+ * Function to free a name table.
+ * The names themselves belong to the students.
+ */
+static void freeNameTable(NameTable_t *table) {
+	free(table->slots);
+	free(table->names);
+	free(table->ranks);
+	free(table->order);
+	table->slots = NULL;
+	table->names = NULL;
+	table->ranks = NULL;
+	table->order = NULL;
+	table->size = table->capacity = table->count = 0;
+}
+
+/**
+ * Function to empty a name table but keep its memory.
+ */
+static void clearNameTable(NameTable_t *table) {
+	if (table->slots != NULL) memset(table->slots, 0, sizeof(uint64_t) * table->size);
+	table->count = 0;
+	table->ranked = false;
+}
+
+/**
+ * Function to find the slot of a name, or the empty slot where it goes.
+ * The hash is kept in the slot, so most other names are skipped without
+ * reading their text.
+ */
+static size_t findSlot(NameTable_t *table, ss_Slice_t name, uint32_t hash) {
+	size_t mask = table->size - 1;
+	size_t slot = hash & mask;
+
+	// Linear probing until the name or an empty slot is found
+	while (table->slots[slot] != 0) {
+		uint64_t entry = table->slots[slot];
+		if ((uint32_t) (entry >> 32) == hash &&
+			compareSlices(table->names[(uint32_t) entry - 1], name) == 0) return slot;
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+/**
+ * Function to double the slots and the names of a name table.
+ * Returns false if memory could not be allocated, leaving the table as it was.
+ */
+static bool growNameTable(NameTable_t *table) {
+	uint64_t *slots = (uint64_t *) allocateZeroed(table->size * 2, sizeof(uint64_t));
+	ss_Slice_t *names = (ss_Slice_t *) reallocate(table->names, sizeof(ss_Slice_t) * table->capacity * 2);
+	if (names != NULL) table->names = names;
+	if (slots == NULL || names == NULL) {
+		free(slots);
+		return false;
+	}
+
+	// Move every name to its slot in the larger table, using the hash kept in its old slot
+	size_t mask = table->size * 2 - 1;
+	for (size_t i = 0; i < table->size; i++) {
+		uint64_t entry = table->slots[i];
+		if (entry == 0) continue;
+		size_t slot = (size_t) (entry >> 32) & mask;
+		while (slots[slot] != 0) slot = (slot + 1) & mask;
+		slots[slot] = entry;
+	}
+	free(table->slots);
+	table->slots = slots;
+	table->size *= 2;
+	table->capacity *= 2;
+	return true;
+}
+
+/**
+ * Function to find the id of a name in the table.
+ * Inserts the name if it is not there yet. The table keeps the slice, so the
+ * text must live as long as the table.
+ * Returns false if memory could not be allocated.
+ */
+static bool findName(NameTable_t *table, ss_Slice_t name, uint32_t *id) {
+	uint32_t hash = (uint32_t) hashName(name);
+	size_t slot = findSlot(table, name, hash);
+	if (table->slots[slot] != 0) {
+		*id = (uint32_t) table->slots[slot] - 1;
+		return true;
+	}
+
+	if (table->count == table->capacity) {
+		if (table->count >= SS_RANK_NONE - 1 || !growNameTable(table)) return false;
+		slot = findSlot(table, name, hash);
+	}
+	table->names[table->count] = name;
+	table->slots[slot] = (uint64_t) hash << 32 | (table->count + 1);
+	*id = (uint32_t) table->count++;
+	return true;
+}
+
+/**
+ * Function to compare two names for qsort.
+ */
+static int compareNames(const void *a, const void *b) {
+	const RankedName_t *x = (const RankedName_t *) a;
+	const RankedName_t *y = (const RankedName_t *) b;
+	if (x->prefix != y->prefix) return (x->prefix < y->prefix) ? -1 : 1;
+	return compareSlices(x->name, y->name);
+}
+
+/**
+ * Function to do one counting pass of the name radix sort.
+ * Stable by the 8 bit digit at shift of the prefix.
+ * Returns false without moving names if every name has the same digit.
+ */
+static bool rankPass(RankedName_t *from, RankedName_t *to, size_t count, int shift) {
+	size_t offsets[256] = {0};
+
+	for (size_t i = 0; i < count; i++) offsets[(from[i].prefix >> shift) & 0xFF]++;
+
+	// Skip the pass if one bucket holds everything
+	for (int digit = 0; digit < 256; digit++) {
+		if (offsets[digit] == count) return false;
+		if (offsets[digit] != 0) break;
+	}
+
+	size_t total = 0;
+	for (int digit = 0; digit < 256; digit++) {
+		size_t bucket = offsets[digit];
+		offsets[digit] = total;
+		total += bucket;
+	}
+
+	for (size_t i = 0; i < count; i++) to[offsets[(from[i].prefix >> shift) & 0xFF]++] = from[i];
+	return true;
+}
+
+/**
+ * Function to rank every name in the table.
+ * Ranks follow strcmp order, so comparing ranks equals comparing names.
+ * Radix sorts the names by their first 8 bytes, then sorts names that
+ * share those by their text.
+ * Returns false if memory could not be allocated.
+ */
+static bool rankNames(NameTable_t *table) {
+	if (table->count == 0) return true;
+
+	RankedName_t *sorted = (RankedName_t *) allocate(sizeof(RankedName_t) * table->count);
+	RankedName_t *temp = (RankedName_t *) allocate(sizeof(RankedName_t) * table->count);
+	uint32_t *ranks = (uint32_t *) reallocate(table->ranks, sizeof(uint32_t) * table->capacity);
+	if (ranks != NULL) table->ranks = ranks;
+	uint32_t *order = (uint32_t *) reallocate(table->order, sizeof(uint32_t) * table->capacity);
+	if (order != NULL) table->order = order;
+	if (sorted == NULL || temp == NULL || ranks == NULL || order == NULL) {
+		free(sorted);
+		free(temp);
+		return false;
+	}
+
+	for (size_t id = 0; id < table->count; id++) {
+		ss_Slice_t name = table->names[id];
+		uint64_t prefix = 0;
+		for (uint32_t i = 0; i < 8; i++)
+			prefix = prefix << 8 | ((i < name.length) ? (unsigned char) name.text[i] : 0);
+		sorted[id].prefix = prefix;
+		sorted[id].name = name;
+		sorted[id].id = (uint32_t) id;
+	}
+	for (int shift = 0; shift < 64; shift += 8)
+		if (rankPass(sorted, temp, table->count, shift)) { RankedName_t *swap = sorted; sorted = temp; temp = swap; }
+
+	size_t end;
+	for (size_t i = 0; i < table->count; i = end) {
+		for (end = i + 1; end < table->count && sorted[end].prefix == sorted[i].prefix; end++);
+		if (end - i > 1) qsort(sorted + i, end - i, sizeof(RankedName_t), compareNames);
+	}
+
+	for (size_t i = 0; i < table->count; i++) {
+		table->ranks[sorted[i].id] = (uint32_t) i;
+		table->order[i] = sorted[i].id;
+	}
+	free(sorted);
+	free(temp);
+	return true;
+}
+
+/**
+ * Function to create the name table of a list, if it has none yet.
+ * Returns false if memory could not be allocated.
+ */
+static bool createNames(ss_StudentList_t *list) {
+	if (list->names != NULL) return true;
+
+	list->names = (NameTable_t *) allocate(sizeof(NameTable_t));
+	if (list->names == NULL) return false;
+	if (!initNameTable(list->names, 1024)) {
+		freeNameTable(list->names);
+		free(list->names);
+		list->names = NULL;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Function to intern a name of a student in the name table of the list.
+ * The name then points at the text of its first use, and rank holds its id
+ * until rankStudents. A copy made for the name since copy_mark is released
+ * if the name was already known.
+ * Returns false if memory could not be allocated.
+ */
+static bool internName(ss_StudentList_t *list, ss_Slice_t *name, uint32_t *rank, bool copied, ArenaMark_t copy_mark) {
+	if (!createNames(list)) return false;
+
+	NameTable_t *table = list->names;
+	size_t count = table->count;
+	if (!findName(table, *name, rank)) return false;
+	if (table->count == count) {
+		*name = table->names[*rank];
+		if (copied) releaseArena(&list->arena, copy_mark);
+	}
+	return true;
+}
+
+/**
+ * Function to get a new id for a set of ranks.
+ * Never 0, which marks a student without ranks.
+ */
+static uint32_t nextRankSet(void) {
+	uint32_t id;
+	do id = __atomic_add_fetch(&rank_sets, 1, __ATOMIC_RELAXED); while (id == 0);
+	return id;
+}
+
+/**
+ * Function to turn the ranks of the students of a list back into ids.
+ * Lets more students be read into a list that was already ranked.
+ */
+static void unrankStudents(ss_StudentList_t *list) {
+	NameTable_t *table = list->names;
+	if (table == NULL || !table->ranked) return;
+
+	for (ss_ListNode_t *node = list->head_a; node != NULL; node = node->next) {
+		ss_Student_t *student = node->student;
+		if (student->last_rank != SS_RANK_NONE) student->last_rank = table->order[student->last_rank];
+		if (student->first_rank != SS_RANK_NONE) student->first_rank = table->order[student->first_rank];
+		student->rank_set = 0;
+	}
+	table->ranked = false;
+}
+
+/**
+ * Function to rank the names of the students of a list.
+ * Turns the id of each name into its rank. If the ranks cannot be allocated,
+ * every rank is set to SS_RANK_NONE so names compare by text.
+ */
+static void rankStudents(ss_StudentList_t *list) {
+	NameTable_t *table = list->names;
+	if (table == NULL || table->ranked) return;
+
+	bool ranked = rankNames(table);
+	uint32_t rank_set = ranked ? nextRankSet() : 0;
+	for (ss_ListNode_t *node = list->head_a; node != NULL; node = node->next) {
+		ss_Student_t *student = node->student;
+		if (student->last_rank != SS_RANK_NONE) student->last_rank = ranked ? table->ranks[student->last_rank] : SS_RANK_NONE;
+		if (student->first_rank != SS_RANK_NONE) student->first_rank = ranked ? table->ranks[student->first_rank] : SS_RANK_NONE;
+		student->rank_set = rank_set;
+	}
+	if (ranked) table->ranked = true;
+	else clearNameTable(table);
+}
+
+/**
+ * Function to wrap an ss_Student_t node in an ss_ListNode_t node.
+ * If the head is NULL, then the head is the node.
+ * Returns false if memory could not be allocated.
+ */
+static bool appendToList(ss_Arena_t *arena, ss_ListNode_t **head, ss_ListNode_t **tail, ss_Student_t *student) {
+	ss_ListNode_t *node = (ss_ListNode_t *) arenaAlloc(arena, sizeof(ss_ListNode_t), _Alignof(ss_ListNode_t));
+	if (node == NULL) return false;
+	node->student = student;
+	node->next = NULL;
+
+	if (*head == NULL) *head = node;
+	else (*tail)->next = node;
+	*tail = node;
+	return true;
+}
+
+/**
+ * Function to append a node to the end of the linked list.
+ */
+static bool appendList(ss_StudentList_t *list, ss_Student_t *new_node, ss_Result_t *result) {
+	if (list == NULL || new_node == NULL) return setError(result, SS_RESULT_INVALID_ARGUMENT, "Error: NULL argument.");
+
+	// Append to all list
+	bool appended = appendToList(&list->arena, &list->head_a, &list->tail_a, new_node);
+
+	// Append to domestic or international list
+	switch (new_node->status_value) {
+		case SS_STATUS_DOMESTIC: appended = appended && appendToList(&list->arena, &list->head_d, &list->tail_d, new_node); break;
+		case SS_STATUS_INTERNATIONAL: appended = appended && appendToList(&list->arena, &list->head_i, &list->tail_i, new_node); break;
+		case SS_STATUS_NONE: break;
+		default: return setError(result, SS_RESULT_INVALID_ARGUMENT, "Error: Invalid status.");
+	}
+	if (!appended) return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+	return true;
+}
+
+/**
+ * Function to free the linked lists.
+ * Students, list nodes and fields all live in the arena, so one release frees them.
+ */
+void ss_freeList(ss_StudentList_t *list) {
+	freeArena(&list->arena);
+	if (list->names != NULL) freeNameTable(list->names);
+	free(list->names);
+	list->names = NULL;
+	list->head_d = list->tail_d = NULL;
+	list->head_i = list->tail_i = NULL;
+	list->head_a = list->tail_a = NULL;
+}
+
+/**
+ * Function to empty the linked lists but keep the memory of the arena.
+ * Lets a caller that keeps running reuse the list for the next input.
+ */
+void ss_clearList(ss_StudentList_t *list) {
+	clearArena(&list->arena);
+	if (list->names != NULL) clearNameTable(list->names);
+	list->head_d = list->tail_d = NULL;
+	list->head_i = list->tail_i = NULL;
+	list->head_a = list->tail_a = NULL;
+	list->top = NULL;
+	list->count_d = list->count_i = list->count_a = 0;
+}
+
+/**
+ * Function to compare by year.
+ * Missing year (SS_YEAR_NONE) sorts last.
+ */
+static int compareByYear(ss_Student_t *a, ss_Student_t *b) {
+	if (a->year_value < b->year_value) return -1; // a is less than b
+	if (a->year_value > b->year_value) return 1; // a is greater than b
+	return 0; // a is equal to b
+}
+
+/**
+ * Function to compare by month.
+ * Compares the index stored by addDate. Missing month sorts last.
+ */
+static int compareByMonth(ss_Student_t *a, ss_Student_t *b) {
+	if (a->month_index < b->month_index) return -1; // a is less than b
+	if (a->month_index > b->month_index) return 1; // a is greater than b
+	return 0; // a is equal to b
+}
+
+/**
+ * Function to compare by day.
+ * Missing day (SS_DAY_NONE) sorts last.
+ */
+static int compareByDay(ss_Student_t *a, ss_Student_t *b) {
+	if (a->day_value < b->day_value) return -1; // a is less than b
+	if (a->day_value > b->day_value) return 1; // a is greater than b
+	return 0; // a is equal to b
+}
+
+/**
+ * Function to compare by last name.
+ * NULL precedes non-NULL. Compares the text, since ranks are only
+ * comparable within one list.
+ */
+static int compareByLastName(ss_Student_t *a, ss_Student_t *b) {
+	if (a->last_name.text == NULL && b->last_name.text != NULL) return 1;
+	if (a->last_name.text != NULL && b->last_name.text == NULL) return -1;
+	if (a->last_name.text == NULL && b->last_name.text == NULL) return 0;
+
+	return compareSlices(a->last_name, b->last_name);
+}
+
+/**
+ * Function to compare by first name.
+ * NULL precedes non-NULL. Compares the text, since ranks are only
+ * comparable within one list.
+ */
+static int compareByFirstName(ss_Student_t *a, ss_Student_t *b) {
+	if (a->first_name.text == NULL && b->first_name.text != NULL) return 1;
+	if (a->first_name.text != NULL && b->first_name.text == NULL) return -1;
+	if (a->first_name.text == NULL && b->first_name.text == NULL) return 0;
+
+	return compareSlices(a->first_name, b->first_name);
+}
+
+/**
+ * Function to compare by GPA.
+ * Missing GPA (SS_GPA_NONE) sorts last.
+ */
+static int compareByGPA(ss_Student_t *a, ss_Student_t *b) {
+	if (a->gpa_value < b->gpa_value) return -1; // a is less than b
+	if (a->gpa_value > b->gpa_value) return 1; // a is greater than b
+	return 0; // a is equal to b
+}
+
+/**
+ * Function to compare by TOEFL.
+ * Domestic precedes international.
+ */
+static int compareByTOEFL(ss_Student_t *a, ss_Student_t *b) {
+	// If no TOEFL, then domestic
+	if (a->toefl_value == SS_TOEFL_NONE && b->toefl_value != SS_TOEFL_NONE) return -1; // a is domestic, b is international
+	if (a->toefl_value != SS_TOEFL_NONE && b->toefl_value == SS_TOEFL_NONE) return 1; // a is international, b is domestic
+
+	// Both have TOEFL or both are domestic, so compare
+	if (a->toefl_value < b->toefl_value) return -1; // a is less than b
+	if (a->toefl_value > b->toefl_value) return 1; // a is greater than b
+	return 0; // a is equal to b
+}
+
+/**
+ * Function to compare by status.
+ * Domestic precedes international. Missing status sorts last.
+ */
+static int compareByStatus(ss_Student_t *a, ss_Student_t *b) {
+	if (a->status_value < b->status_value) return -1; // a is less than b
+	if (a->status_value > b->status_value) return 1; // a is greater than b
+	return 0; // a is equal to b
+}
+
+/**
+ * Function to compare two students.
+ * Compares by all fields.
+ */
+int ss_compareStudents(ss_Student_t *a, ss_Student_t *b) {
+	int result;
+	if (collect_stats) counters.compares++;
+
+	// Use each compare function in the given order until a difference is found
+	if ((result = compareByYear(a, b)) != 0) return result;
+	if ((result = compareByMonth(a, b)) != 0) return result;
+	if ((result = compareByDay(a, b)) != 0) return result;
+	if ((result = compareByLastName(a, b)) != 0) return result;
+	if ((result = compareByFirstName(a, b)) != 0) return result;
+	if ((result = compareByGPA(a, b)) != 0) return result;
+	if ((result = compareByTOEFL(a, b)) != 0) return result;
+	if ((result = compareByStatus(a, b)) != 0) return result;
+
+	return 0; // a is equal to b
+}
+
+/**
+ * Function to merge two sorted linked lists.
+ * Merges by all fields. Iterative, so stack use does not grow with length.
+ * Ties take from left first, which keeps the sort stable.
+ */
+static ss_ListNode_t *mergeList(ss_ListNode_t *left, ss_ListNode_t *right) {
+	ss_ListNode_t result;
+	ss_ListNode_t *tail = &result;
+
+	while (left != NULL && right != NULL) {
+		if (ss_compareStudents(left->student, right->student) <= 0) {
+			tail->next = left;
+			left = left->next;
+		} else {
+			tail->next = right;
+			right = right->next;
+		}
+		tail = tail->next;
+	}
+	tail->next = (left != NULL) ? left : right;
+
+	return result.next;
+}
+
+/**
+ * Function to sort a linked list using bottom-up merge sort.
+ * Sorts by all fields.
+ *
+ * Nodes are taken one at a time and carried through bins like a binary
+ * counter, where bins[i] holds a sorted run of 2^i nodes. No recursion
+ * and no split pass. Bins always hold nodes that came before the carry,
+ * so they are merged as the left side to keep the sort stable.
+ */
+void ss_sortList(ss_ListNode_t **head) {
+	if (*head == NULL || (*head)->next == NULL) return;
+
+	ss_ListNode_t *bins[64] = {NULL};
+	int max_bin = 0;
+	ss_ListNode_t *current = *head;
+
+	while (current != NULL) {
+		// Detach the next node as a run of one
+		ss_ListNode_t *carry = current;
+		current = current->next;
+		carry->next = NULL;
+
+		// Merge with full bins until an empty one is found
+		int i = 0;
+		while (i < 64 && bins[i] != NULL) {
+			carry = mergeList(bins[i], carry);
+			bins[i] = NULL;
+			i++;
+		}
+		if (i == 64) i = 63;
+		bins[i] = carry;
+		if (i > max_bin) max_bin = i;
+	}
+
+	// Lower bins hold later nodes, so each result is the right side
+	ss_ListNode_t *result = NULL;
+	for (int i = 0; i <= max_bin; i++)
+		if (bins[i] != NULL) result = mergeList(bins[i], result);
+
+	*head = result;
+}
+
+/**
+ * Function to merge two adjacent runs.
+ * If the runs are already in order they are joined without merging.
+ */
+static Run_t mergeRuns(Run_t left, Run_t right) {
+	Run_t result;
+	result.length = left.length + right.length;
+
+	if (ss_compareStudents(left.tail->student, right.head->student) <= 0) {
+		left.tail->next = right.head;
+		result.head = left.head;
+		result.tail = right.tail;
+		return result;
+	}
+
+	// Ties go to left first, so right's tail is last unless left's tail is greater
+	result.tail = (ss_compareStudents(left.tail->student, right.tail->student) <= 0) ? right.tail : left.tail;
+	result.head = mergeList(left.head, right.head);
+	return result;
+}
+
+/**
+ * Function to merge the pending run at index with the one after it.
+ */
+static void mergeAt(Run_t *runs, int *run_count, int index) {
+	runs[index] = mergeRuns(runs[index], runs[index + 1]);
+	for (int i = index + 1; i < *run_count - 1; i++) runs[i] = runs[i + 1];
+	(*run_count)--;
+}
+
+/**
+ * Function to merge pending runs until their lengths are balanced.
+ * Same rules as TimSort, so each node takes part in O(log n) merges.
+ */
+static void collapseRuns(Run_t *runs, int *run_count) {
+	while (*run_count > 1) {
+		int n = *run_count - 2;
+		if ((n > 0 && runs[n - 1].length <= runs[n].length + runs[n + 1].length) ||
+			(n > 1 && runs[n - 2].length <= runs[n - 1].length + runs[n].length)) {
+			if (runs[n - 1].length < runs[n + 1].length) n--;
+		} else if (runs[n].length > runs[n + 1].length) {
+			break; // Balanced
+		}
+		mergeAt(runs, run_count, n);
+	}
+}
+
+/**
+ * Function to sort a linked list using natural merge sort.
+ * Sorts by all fields.
+ *
+ * One pass cuts the list into runs that are already in order. Strictly
+ * descending runs are reversed, which keeps the sort stable. Runs are then
+ * merged with their neighbours, so a sorted list costs n - 1 compares and a
+ * sorted list with a few rows appended is close to linear.
+ */
+static void naturalSortList(ss_ListNode_t **head) {
+	if (*head == NULL || (*head)->next == NULL) return;
+
+	Run_t runs[MAX_RUNS];
+	int run_count = 0;
+	ss_ListNode_t *current = *head;
+
+	while (current != NULL) {
+		Run_t run;
+		run.length = 1;
+
+		if (current->next != NULL && ss_compareStudents(current->student, current->next->student) > 0) {
+			// Strictly descending run, so reverse it while walking
+			ss_ListNode_t *previous = NULL;
+			run.tail = current;
+			while (true) {
+				ss_ListNode_t *next = current->next;
+				current->next = previous;
+				previous = current;
+				if (next == NULL || ss_compareStudents(current->student, next->student) <= 0) {
+					current = next;
+					break;
+				}
+				current = next;
+				run.length++;
+			}
+			run.head = previous;
+		} else {
+			// Non-descending run
+			run.head = current;
+			while (current->next != NULL && ss_compareStudents(current->student, current->next->student) <= 0) {
+				current = current->next;
+				run.length++;
+			}
+			run.tail = current;
+			current = current->next;
+			run.tail->next = NULL;
+		}
+
+		runs[run_count++] = run;
+		collapseRuns(runs, &run_count);
+	}
+
+	// Merge what is left from the top of the stack down
+	while (run_count > 1) mergeAt(runs, &run_count, run_count - 2);
+
+	*head = runs[0].head;
+}
+
+/**
+ * Function to sort part of a node array.
+ * Links the part into a list, sorts it with ss_sortList, then writes it back.
+ */
+static void *sortPart(void *arg) {
+	SortTask_t *task = (SortTask_t *) arg;
+	Counters_t before = counters;
+	ss_ListNode_t **nodes = task->left;
+	size_t length = task->left_length;
+
+	for (size_t i = 0; i + 1 < length; i++) nodes[i]->next = nodes[i + 1];
+	nodes[length - 1]->next = NULL;
+
+	ss_ListNode_t *head = nodes[0];
+	ss_sortList(&head);
+	for (size_t i = 0; i < length; i++, head = head->next) nodes[i] = head;
+
+	task->work.compares = counters.compares - before.compares;
+	return NULL;
+}
+
+/**
+ * Function to find how many of the first k merged nodes come from left.
+ * Ties take from left first, the same as mergeList.
+ */
+static size_t coRank(size_t k, ss_ListNode_t **left, size_t left_length, ss_ListNode_t **right, size_t right_length) {
+	size_t low = (k > right_length) ? k - right_length : 0;
+	size_t high = (k < left_length) ? k : left_length;
+
+	// Find the smallest i where left[i] does not belong before right[k - i - 1]
+	while (low < high) {
+		size_t i = low + (high - low) / 2;
+		size_t j = k - i;
+		if (j > 0 && ss_compareStudents(left[i]->student, right[j - 1]->student) <= 0) low = i + 1;
+		else high = i;
+	}
+
+	return low;
+}
+
+/**
+ * Function to merge one slice of two sorted node arrays.
+ * Each task finds its own start with coRank, so slices merge in parallel.
+ */
+static void *mergePart(void *arg) {
+	SortTask_t *task = (SortTask_t *) arg;
+	Counters_t before = counters;
+	size_t i = coRank(task->out_begin, task->left, task->left_length, task->right, task->right_length);
+	size_t j = task->out_begin - i;
+
+	for (size_t k = task->out_begin; k < task->out_end; k++) {
+		if (j >= task->right_length ||
+			(i < task->left_length && ss_compareStudents(task->left[i]->student, task->right[j]->student) <= 0))
+			task->out[k] = task->left[i++];
+		else
+			task->out[k] = task->right[j++];
+	}
+
+	task->work.compares = counters.compares - before.compares;
+	return NULL;
+}
+
+/**
+ * Function to run tasks on threads and wait for them.
+ * Each task is task_size bytes and starts with the Counters_t of its work.
+ * A task that cannot get a thread runs on the calling thread, so this never fails.
+ */
+static void runTasks(void *(*function)(void *), void *tasks, size_t task_size, int task_count) {
+	pthread_t *threads = (pthread_t *) allocate(sizeof(pthread_t) * task_count);
+	bool *started = (bool *) allocateZeroed(task_count, sizeof(bool));
+	char *task = (char *) tasks;
+
+	// The calling thread runs the first task itself
+	for (int t = 1; t < task_count; t++) {
+		if (threads != NULL && started != NULL)
+			started[t] = (pthread_create(&threads[t], NULL, function, task + t * task_size) == 0);
+		if (started == NULL || !started[t]) function(task + t * task_size);
+	}
+	function(task);
+
+	// Work done on other threads counts for the calling thread
+	for (int t = 1; t < task_count; t++) {
+		if (started == NULL || !started[t]) continue;
+		pthread_join(threads[t], NULL);
+		Counters_t *work = (Counters_t *) (task + t * task_size);
+		counters.compares += work->compares;
+		counters.allocations += work->allocations;
+		counters.bytes_written += work->bytes_written;
+	}
+
+	free(threads);
+	free(started);
+}
+
+/**
+ * Function to sort a linked list using merge sort across threads.
+ * Sorts by all fields.
+ *
+ * The list is split into one part per thread, in order, and each part is
+ * sorted with ss_sortList. Parts are then merged in pairs, round by round, and
+ * each pair merge is itself split across the threads by output position.
+ * Ties always take from the earlier part, so the output is the same as ss_sortList.
+ * Falls back to ss_sortList if the arrays cannot be allocated.
+ */
+static void parallelSortList(ss_ListNode_t **head, int thread_count) {
+	if (*head == NULL || (*head)->next == NULL) return;
+
+	size_t count = 0;
+	for (ss_ListNode_t *current = *head; current != NULL; current = current->next) count++;
+
+	if ((size_t) thread_count > count / PARALLEL_GRAIN) thread_count = (int) (count / PARALLEL_GRAIN);
+	if (thread_count <= 1) {
+		ss_sortList(head);
+		return;
+	}
+
+	ss_ListNode_t **nodes = (ss_ListNode_t **) allocate(sizeof(ss_ListNode_t *) * count);
+	ss_ListNode_t **temp = (ss_ListNode_t **) allocate(sizeof(ss_ListNode_t *) * count);
+	size_t *bounds = (size_t *) allocate(sizeof(size_t) * (thread_count + 1));
+	SortTask_t *tasks = (SortTask_t *) allocate(sizeof(SortTask_t) * thread_count * 2);
+	if (nodes == NULL || temp == NULL || bounds == NULL || tasks == NULL) {
+		free(nodes);
+		free(temp);
+		free(bounds);
+		free(tasks);
+		ss_sortList(head);
+		return;
+	}
+
+	size_t i = 0;
+	for (ss_ListNode_t *current = *head; current != NULL; current = current->next) nodes[i++] = current;
+
+	// Sort each part on its own thread
+	for (int t = 0; t <= thread_count; t++) bounds[t] = count * t / thread_count;
+	for (int t = 0; t < thread_count; t++) {
+		tasks[t].left = nodes + bounds[t];
+		tasks[t].left_length = bounds[t + 1] - bounds[t];
+	}
+	runTasks(sortPart, tasks, sizeof(SortTask_t), thread_count);
+
+	// Merge neighbouring parts until one is left
+	int part_count = thread_count;
+	while (part_count > 1) {
+		int task_count = 0;
+		int next_count = 0;
+
+		for (int p = 0; p < part_count; p += 2) {
+			size_t begin = bounds[p];
+			size_t middle = bounds[p + 1];
+			size_t end = (p + 2 <= part_count) ? bounds[p + 2] : middle;
+
+			// Give each pair a share of threads by size, at least one
+			int pieces = (int) ((end - begin) * thread_count / count);
+			if (pieces < 1) pieces = 1;
+			for (int piece = 0; piece < pieces; piece++) {
+				SortTask_t *task = &tasks[task_count++];
+				task->left = nodes + begin;
+				task->left_length = middle - begin;
+				task->right = nodes + middle;
+				task->right_length = end - middle;
+				task->out = temp + begin;
+				task->out_begin = (end - begin) * piece / pieces;
+				task->out_end = (end - begin) * (piece + 1) / pieces;
+			}
+			bounds[next_count++] = begin;
+		}
+		bounds[next_count] = count;
+		runTasks(mergePart, tasks, sizeof(SortTask_t), task_count);
+
+		ss_ListNode_t **swap = nodes;
+		nodes = temp;
+		temp = swap;
+		part_count = next_count;
+	}
+
+	// Relink the list in sorted order
+	for (i = 0; i + 1 < count; i++) nodes[i]->next = nodes[i + 1];
+	nodes[count - 1]->next = NULL;
+	*head = nodes[0];
+
+	free(nodes);
+	free(temp);
+	free(bounds);
+	free(tasks);
+}
+
+/**
+ * Function to count the bits needed to store values below limit.
+ */
+static int bitsFor(uint64_t limit) {
+	int bits = 0;
+	while (bits < 64 && (limit - 1) >> bits != 0) bits++;
+	return bits;
+}
+
+/**
+ * Function to pack the non-name fields of a student into a key.
+ * Unsigned order of the key matches ss_compareStudents for those fields.
+ */
+static uint64_t studentKey(ss_Student_t *student) {
+	uint64_t year = (student->year_value == SS_YEAR_NONE) ? 61 : (uint64_t) (student->year_value - 1950); // 6 bits
+	uint64_t month = student->month_index; // 4 bits
+	uint64_t day = (student->day_value == SS_DAY_NONE) ? 32 : student->day_value; // 6 bits
+	uint64_t gpa = student->gpa_value; // 16 bits
+	uint64_t toefl = (uint8_t) (student->toefl_value + 1); // 8 bits, SS_TOEFL_NONE wraps to 0 so it sorts first
+	uint64_t status = student->status_value; // 2 bits
+
+	uint64_t date = year << 10 | month << 6 | day;
+	return date << KEY_DATE_SHIFT | gpa << 10 | toefl << 2 | status;
+}
+
+/**
+ * Function to do one counting pass of the radix sort.
+ * Stable by the 8 bit digit at shift of either the key or the name.
+ * Returns false without moving items if every item has the same digit.
+ */
+static bool radixPass(SortItem_t *from, SortItem_t *to, size_t count, bool by_name, int shift) {
+	size_t offsets[256] = {0};
+
+	for (size_t i = 0; i < count; i++)
+		offsets[((by_name ? from[i].name : from[i].key) >> shift) & 0xFF]++;
+
+	// Skip the pass if one bucket holds everything
+	for (int digit = 0; digit < 256; digit++) {
+		if (offsets[digit] == count) return false;
+		if (offsets[digit] != 0) break;
+	}
+
+	size_t total = 0;
+	for (int digit = 0; digit < 256; digit++) {
+		size_t bucket = offsets[digit];
+		offsets[digit] = total;
+		total += bucket;
+	}
+
+	for (size_t i = 0; i < count; i++)
+		to[offsets[((by_name ? from[i].name : from[i].key) >> shift) & 0xFF]++] = from[i];
+	return true;
+}
+
+/**
+ * Function to free the arrays of a table.
+ */
+static void freeTable(StudentTable_t *table) {
+	free(table->date);
+	free(table->name);
+	free(table->rest);
+	free(table->nodes);
+	memset(table, 0, sizeof(*table));
+}
+
+/**
+ * Function to fill a table with the sort fields of a list.
+ * Uses the ranks from reading if every name has one from the same rank set,
+ * otherwise ranks the names here, so students of any lists sort the same.
+ * Returns false if memory could not be allocated or the list is too long.
+ */
+static bool buildTable(StudentTable_t *table, ss_ListNode_t *head) {
+	memset(table, 0, sizeof(*table));
+	for (ss_ListNode_t *current = head; current != NULL; current = current->next) table->count++;
+	if (table->count > UINT32_MAX) return false;
+
+	bool ranked = true;
+	uint64_t rank_limit = 0;
+	uint32_t rank_set = 0; // Set of the first ranked student, which every other must share
+	for (ss_ListNode_t *current = head; current != NULL && ranked; current = current->next) {
+		ss_Student_t *student = current->student;
+		if (student->last_name.text != NULL || student->first_name.text != NULL) {
+			if (rank_set == 0) rank_set = student->rank_set;
+			ranked = student->rank_set != 0 && student->rank_set == rank_set;
+		}
+		if (student->last_name.text != NULL) {
+			ranked = ranked && student->last_rank != SS_RANK_NONE;
+			if (student->last_rank >= rank_limit) rank_limit = (uint64_t) student->last_rank + 1;
+		}
+		if (student->first_name.text != NULL) {
+			ranked = ranked && student->first_rank != SS_RANK_NONE;
+			if (student->first_rank >= rank_limit) rank_limit = (uint64_t) student->first_rank + 1;
+		}
+	}
+
+	size_t count = table->count;
+	table->date = (uint16_t *) allocate(sizeof(uint16_t) * count);
+	table->name = (uint64_t *) allocate(sizeof(uint64_t) * count);
+	table->rest = (uint32_t *) allocate(sizeof(uint32_t) * count);
+	table->nodes = (ss_ListNode_t **) allocate(sizeof(ss_ListNode_t *) * count);
+	NameTable_t names;
+	memset(&names, 0, sizeof(names));
+	bool ready = table->date != NULL && table->name != NULL && table->rest != NULL && table->nodes != NULL;
+	if (ready && !ranked) {
+		ready = initNameTable(&names, count);
+		uint32_t id;
+		for (ss_ListNode_t *current = head; current != NULL && ready; current = current->next) {
+			if (current->student->last_name.text != NULL) ready = findName(&names, current->student->last_name, &id);
+			if (current->student->first_name.text != NULL) ready = ready && findName(&names, current->student->first_name, &id);
+		}
+		ready = ready && rankNames(&names);
+		rank_limit = names.count;
+	}
+	if (!ready) {
+		freeNameTable(&names);
+		freeTable(table);
+		return false;
+	}
+	int first_bits = bitsFor(rank_limit + 1);
+	table->name_bits = first_bits * 2;
+
+	// Missing names get the highest rank so they sort last
+	size_t i = 0;
+	for (ss_ListNode_t *current = head; current != NULL; current = current->next, i++) {
+		ss_Student_t *student = current->student;
+		uint64_t last = rank_limit;
+		uint64_t first = rank_limit;
+		uint32_t id;
+		if (student->last_name.text != NULL) {
+			if (ranked) last = student->last_rank;
+			else if (findName(&names, student->last_name, &id)) last = names.ranks[id];
+		}
+		if (student->first_name.text != NULL) {
+			if (ranked) first = student->first_rank;
+			else if (findName(&names, student->first_name, &id)) first = names.ranks[id];
+		}
+
+		uint64_t key = studentKey(student);
+		table->date[i] = (uint16_t) (key >> KEY_DATE_SHIFT);
+		table->name[i] = last << first_bits | first;
+		table->rest[i] = (uint32_t) key;
+		table->nodes[i] = current;
+	}
+	freeNameTable(&names);
+	return true;
+}
+
+/**
+ * Function to compare two rows of a table.
+ * Same order as ss_compareStudents on their students.
+ */
+static inline int compareRows(const StudentTable_t *table, uint32_t a, uint32_t b) {
+	if (collect_stats) counters.compares++;
+
+	if (table->date[a] != table->date[b]) return (table->date[a] < table->date[b]) ? -1 : 1;
+	if (table->name[a] != table->name[b]) return (table->name[a] < table->name[b]) ? -1 : 1;
+	if (table->rest[a] != table->rest[b]) return (table->rest[a] < table->rest[b]) ? -1 : 1;
+	return 0;
+}
+
+/**
+ * Function to merge the sorted rows from[begin, middle) and from[middle, end) into to.
+ * Ties take from left first. Copies without merging if the runs are already in order.
+ */
+static void mergeRows(const StudentTable_t *table, const uint32_t *from, uint32_t *to, size_t begin, size_t middle, size_t end) {
+	if (middle == end || compareRows(table, from[middle - 1], from[middle]) <= 0) {
+		memcpy(to + begin, from + begin, sizeof(uint32_t) * (end - begin));
+		return;
+	}
+
+	size_t left = begin;
+	size_t right = middle;
+	size_t out = begin;
+	while (left < middle && right < end) {
+		if (compareRows(table, from[left], from[right]) <= 0) to[out++] = from[left++];
+		else to[out++] = from[right++];
+	}
+	while (left < middle) to[out++] = from[left++];
+	while (right < end) to[out++] = from[right++];
+}
+
+/**
+ * Function to sort a linked list through a table of its sort fields.
+ * Same order as ss_sortList for any list, including students of several
+ * lists or built by hand, since buildTable only keeps ranks of one rank set.
+ * Stable. Sorts an array of row numbers with insertion sort on short runs,
+ * then bottom-up merge passes, and relinks the list once at the end. Falls
+ * back to ss_sortList if memory could not be allocated.
+ */
+static void tableSortList(ss_ListNode_t **head) {
+	if (*head == NULL || (*head)->next == NULL) return;
+
+	StudentTable_t table;
+	if (!buildTable(&table, *head)) {
+		ss_sortList(head);
+		return;
+	}
+	size_t count = table.count;
+	uint32_t *order = (uint32_t *) allocate(sizeof(uint32_t) * count);
+	uint32_t *temp = (uint32_t *) allocate(sizeof(uint32_t) * count);
+	if (order == NULL || temp == NULL) {
+		free(order);
+		free(temp);
+		freeTable(&table);
+		ss_sortList(head);
+		return;
+	}
+
+	// Insertion sort each run, moving a row only past greater rows so ties keep their order
+	for (size_t begin = 0; begin < count; begin += TABLE_RUN) {
+		size_t end = (begin + TABLE_RUN < count) ? begin + TABLE_RUN : count;
+		for (size_t i = begin; i < end; i++) {
+			uint32_t row = (uint32_t) i;
+			size_t j = i;
+			while (j > begin && compareRows(&table, order[j - 1], row) > 0) {
+				order[j] = order[j - 1];
+				j--;
+			}
+			order[j] = row;
+		}
+	}
+
+	// Merge pairs of runs, doubling the width each pass
+	for (size_t width = TABLE_RUN; width < count; width *= 2) {
+		for (size_t begin = 0; begin < count; begin += 2 * width) {
+			size_t middle = (begin + width < count) ? begin + width : count;
+			size_t end = (middle + width < count) ? middle + width : count;
+			mergeRows(&table, order, temp, begin, middle, end);
+		}
+		uint32_t *swap = order;
+		order = temp;
+		temp = swap;
+	}
+
+	// Relink the list in sorted order
+	for (size_t i = 0; i + 1 < count; i++) table.nodes[order[i]]->next = table.nodes[order[i + 1]];
+	table.nodes[order[count - 1]]->next = NULL;
+	*head = table.nodes[order[0]];
+
+	free(order);
+	free(temp);
+	freeTable(&table);
+}
+
+/**
+ * Function to sort a linked list using LSD radix sort.
+ * Same order as ss_sortList, and stable so ties keep input order.
+ * Falls back to ss_sortList if the arrays cannot be allocated.
+ */
+static void radixSortList(ss_ListNode_t **head) {
+	if (*head == NULL || (*head)->next == NULL) return;
+
+	StudentTable_t table;
+	if (!buildTable(&table, *head)) {
+		ss_sortList(head);
+		return;
+	}
+	size_t count = table.count;
+	SortItem_t *items = (SortItem_t *) allocate(sizeof(SortItem_t) * count);
+	SortItem_t *temp = (SortItem_t *) allocate(sizeof(SortItem_t) * count);
+	if (items == NULL || temp == NULL) {
+		free(items);
+		free(temp);
+		freeTable(&table);
+		ss_sortList(head);
+		return;
+	}
+	int name_bits = table.name_bits;
+
+	for (size_t i = 0; i < count; i++) {
+		items[i].key = (uint64_t) table.date[i] << KEY_DATE_SHIFT | table.rest[i];
+		items[i].name = table.name[i];
+		items[i].node = table.nodes[i];
+	}
+	freeTable(&table);
+
+	// Least significant first: low key fields, then names, then date
+	for (int shift = 0; shift < KEY_LOW_BITS; shift += 8)
+		if (radixPass(items, temp, count, false, shift)) { SortItem_t *swap = items; items = temp; temp = swap; }
+	for (int shift = 0; shift < name_bits; shift += 8)
+		if (radixPass(items, temp, count, true, shift)) { SortItem_t *swap = items; items = temp; temp = swap; }
+	for (int shift = KEY_DATE_SHIFT; shift < KEY_DATE_SHIFT + KEY_DATE_BITS; shift += 8)
+		if (radixPass(items, temp, count, false, shift)) { SortItem_t *swap = items; items = temp; temp = swap; }
+
+	// Relink the list in sorted order
+	for (size_t i = 0; i + 1 < count; i++) items[i].node->next = items[i + 1].node;
+	items[count - 1].node->next = NULL;
+	*head = items[0].node;
+
+	free(items);
+	free(temp);
+}
+
+/**
+ * Function to compare two students by the fields of a key in turn.
+ * Same order as the encoded key, for when the encoding cannot be allocated.
+ */
+static int compareByKey(ss_Student_t *a, ss_Student_t *b, const ss_SortKey_t *key) {
+	static int (*const compares[SS_SORT_FIELDS])(ss_Student_t *, ss_Student_t *) = {
+		compareByYear, compareByMonth, compareByDay, compareByLastName,
+		compareByFirstName, compareByGPA, compareByTOEFL, compareByStatus
+	};
+	for (int i = 0; i < SS_SORT_FIELDS; i++) {
+		int result = compares[key->fields[i]](a, b);
+		if (result != 0) return key->descending[i] ? -result : result;
+	}
+	return 0;
+}
+
+/**
+ * Function to merge two sorted linked lists by a key.
+ * Ties take from left first, as in mergeList.
+ */
+static ss_ListNode_t *mergeByKey(ss_ListNode_t *left, ss_ListNode_t *right, const ss_SortKey_t *key) {
+	ss_ListNode_t result;
+	ss_ListNode_t *tail = &result;
+
+	while (left != NULL && right != NULL) {
+		if (compareByKey(left->student, right->student, key) <= 0) {
+			tail->next = left;
+			left = left->next;
+		} else {
+			tail->next = right;
+			right = right->next;
+		}
+		tail = tail->next;
+	}
+	tail->next = (left != NULL) ? left : right;
+
+	return result.next;
+}
+
+/**
+ * Function to sort a linked list by a key with bottom-up merge sort.
+ * The fallback of keyedSortList, same steps as ss_sortList.
+ */
+static void mergeSortByKey(ss_ListNode_t **head, const ss_SortKey_t *key) {
+	ss_ListNode_t *bins[64] = {NULL};
+	int max_bin = 0;
+	ss_ListNode_t *current = *head;
+
+	while (current != NULL) {
+		ss_ListNode_t *carry = current;
+		current = current->next;
+		carry->next = NULL;
+
+		int i = 0;
+		while (i < 64 && bins[i] != NULL) {
+			carry = mergeByKey(bins[i], carry, key);
+			bins[i] = NULL;
+			i++;
+		}
+		if (i == 64) i = 63;
+		bins[i] = carry;
+		if (i > max_bin) max_bin = i;
+	}
+
+	ss_ListNode_t *result = NULL;
+	for (int i = 0; i <= max_bin; i++)
+		if (bins[i] != NULL) result = mergeByKey(bins[i], result, key);
+
+	*head = result;
+}
+
+/**
+ * Function to sort a linked list by a key using LSD radix sort.
+ *
+ * Each student is encoded once into a 128 bit number, the fields of the key
+ * packed from most to least significant at the widths of studentKey, with
+ * descending fields inverted. Sorting the numbers is then the same work for
+ * every key. The high half goes in SortItem_t key and the low half in name.
+ * Stable, so ties keep input order. Falls back to mergeSortByKey if the
+ * arrays cannot be allocated.
+ */
+static void keyedSortList(ss_ListNode_t **head, const ss_SortKey_t *key) {
+	if (*head == NULL || (*head)->next == NULL) return;
+
+	StudentTable_t table;
+	if (!buildTable(&table, *head)) {
+		mergeSortByKey(head, key);
+		return;
+	}
+	size_t count = table.count;
+	SortItem_t *items = (SortItem_t *) allocate(sizeof(SortItem_t) * count);
+	SortItem_t *temp = (SortItem_t *) allocate(sizeof(SortItem_t) * count);
+	if (items == NULL || temp == NULL) {
+		free(items);
+		free(temp);
+		freeTable(&table);
+		mergeSortByKey(head, key);
+		return;
+	}
+
+	// Width of each field in the order of ss_SortField_t, then in the order of the key
+	int first_bits = table.name_bits / 2;
+	const int field_bits[SS_SORT_FIELDS] = {6, 4, 6, first_bits, first_bits, 16, 8, 2};
+	int widths[SS_SORT_FIELDS];
+	int total_bits = 0;
+	for (int j = 0; j < SS_SORT_FIELDS; j++) {
+		widths[j] = field_bits[key->fields[j]];
+		total_bits += widths[j];
+	}
+
+	uint64_t first_mask = ((uint64_t) 1 << first_bits) - 1;
+	for (size_t i = 0; i < count; i++) {
+		uint64_t date = table.date[i];
+		uint64_t rest = table.rest[i];
+		const uint64_t values[SS_SORT_FIELDS] = {
+			date >> 10, (date >> 6) & 15, date & 63, table.name[i] >> first_bits,
+			table.name[i] & first_mask, rest >> 10, (rest >> 2) & 255, rest & 3
+		};
+
+		uint64_t high = 0;
+		uint64_t low = 0;
+		for (int j = 0; j < SS_SORT_FIELDS; j++) {
+			int width = widths[j];
+			if (width == 0) continue;
+			uint64_t mask = ((uint64_t) 1 << width) - 1;
+			uint64_t value = values[key->fields[j]];
+			if (key->descending[j]) value = mask - value;
+			high = (high << width) | (low >> (64 - width));
+			low = (low << width) | value;
+		}
+		items[i].key = high;
+		items[i].name = low;
+		items[i].node = table.nodes[i];
+	}
+	freeTable(&table);
+
+	// Least significant first: the low half, then the high half
+	for (int shift = 0; shift < total_bits && shift < 64; shift += 8)
+		if (radixPass(items, temp, count, true, shift)) { SortItem_t *swap = items; items = temp; temp = swap; }
+	for (int shift = 0; shift < total_bits - 64; shift += 8)
+		if (radixPass(items, temp, count, false, shift)) { SortItem_t *swap = items; items = temp; temp = swap; }
+
+	// Relink the list in sorted order, from the back
+	ss_ListNode_t *sorted = NULL;
+	for (size_t i = count; i > 0; i--) {
+		items[i - 1].node->next = sorted;
+		sorted = items[i - 1].node;
+	}
+	*head = sorted;
+
+	free(items);
+	free(temp);
+}
+
+/**
+ * Function to compile a key spec into a sort order.
+ */
+bool ss_compileSortKey(const char *spec, ss_SortKey_t *key, ss_Result_t *result) {
+	static const char *names[SS_SORT_FIELDS] = {"year", "month", "day", "last", "first", "gpa", "toefl", "status"};
+	const char *invalid = "Error: Invalid sort key.";
+	bool used[SS_SORT_FIELDS] = {false};
+	int count = 0;
+
+	const char *part = spec;
+	while (part != NULL && *part != '\0') {
+		const char *end = strchr(part, ',');
+		size_t length = (end != NULL) ? (size_t) (end - part) : strlen(part);
+		const char *colon = memchr(part, ':', length);
+		size_t name_length = (colon != NULL) ? (size_t) (colon - part) : length;
+
+		int field = 0;
+		while (field < SS_SORT_FIELDS && (strlen(names[field]) != name_length || strncmp(names[field], part, name_length) != 0))
+			field++;
+		if (field == SS_SORT_FIELDS || used[field]) return setError(result, SS_RESULT_INVALID_ARGUMENT, invalid);
+
+		bool descending = false;
+		if (colon != NULL) {
+			size_t direction_length = length - name_length - 1;
+			if (direction_length == 4 && strncmp(colon + 1, "desc", 4) == 0) descending = true;
+			else if (direction_length != 3 || strncmp(colon + 1, "asc", 3) != 0)
+				return setError(result, SS_RESULT_INVALID_ARGUMENT, invalid);
+		}
+
+		used[field] = true;
+		key->fields[count] = (ss_SortField_t) field;
+		key->descending[count] = descending;
+		count++;
+		part = (end != NULL) ? end + 1 : NULL;
+		if (part != NULL && *part == '\0') return setError(result, SS_RESULT_INVALID_ARGUMENT, invalid);
+	}
+	if (count == 0) return setError(result, SS_RESULT_INVALID_ARGUMENT, invalid);
+
+	// Fields left out break ties in the default order
+	for (int field = 0; field < SS_SORT_FIELDS; field++) {
+		if (used[field]) continue;
+		key->fields[count] = (ss_SortField_t) field;
+		key->descending[count] = false;
+		count++;
+	}
+
+	key->custom = false;
+	for (int i = 0; i < SS_SORT_FIELDS; i++)
+		if (key->fields[i] != (ss_SortField_t) i || key->descending[i]) key->custom = true;
+	return true;
+}
+
+/**
+ * Function to setup a top list that keeps the first limit students.
+ */
+static void initTopList(TopList_t *top, size_t limit, int option) {
+	top->entries = NULL;
+	top->heap = NULL;
+	top->count = 0;
+	top->capacity = 0;
+	top->limit = limit;
+	top->option = option;
+	top->sequence = 0;
+}
+
+/**
+ * Function to make room for more entries in a top list.
+ * Doubles the arrays, but never past the limit.
+ */
+static bool growTopList(TopList_t *top) {
+	size_t capacity = (top->capacity == 0) ? 64 : top->capacity * 2;
+	if (capacity > top->limit || capacity < top->capacity) capacity = top->limit;
+	if (capacity > SIZE_MAX / sizeof(TopEntry_t)) return false;
+
+	size_t *heap = (size_t *) reallocate(top->heap, sizeof(size_t) * capacity);
+	if (heap == NULL) return false;
+	top->heap = heap;
+	TopEntry_t *entries = (TopEntry_t *) reallocate(top->entries, sizeof(TopEntry_t) * capacity);
+	if (entries == NULL) return false;
+	memset(entries + top->capacity, 0, sizeof(TopEntry_t) * (capacity - top->capacity));
+	top->entries = entries;
+	top->capacity = capacity;
+	return true;
+}
+
+/**
+ * Function to free a top list.
+ * Every allocated entry holds its own text, even after writeTop empties the heap.
+ */
+static void freeTopList(TopList_t *top) {
+	for (size_t i = 0; i < top->capacity; i++) free(top->entries[i].text);
+	free(top->entries);
+	free(top->heap);
+}
+
+/**
+ * Function to check if entry a goes after entry b.
+ * Ties go by input order.
+ */
+static bool topAfter(TopEntry_t *a, TopEntry_t *b) {
+	int result = ss_compareStudents(&a->student, &b->student);
+	return result > 0 || (result == 0 && a->sequence > b->sequence);
+}
+
+/**
+ * Function to count the text of every field of a student.
+ */
+static size_t studentTextLength(const ss_Student_t *student) {
+	return (size_t) student->first_name.length + student->last_name.length + student->birth_month.length
+		+ student->birth_day.length + student->birth_year.length + student->gpa.length
+		+ student->status.length + student->toefl.length;
+}
+
+/**
+ * Function to copy a student and its text.
+ * Text must hold studentTextLength of the student. The copy has no name ranks,
+ * so it compares with students of any list.
+ */
+static void copyStudent(ss_Student_t *copy, const ss_Student_t *student, char *text) {
+	const ss_Slice_t *from[] = {
+		&student->first_name, &student->last_name, &student->birth_month, &student->birth_day,
+		&student->birth_year, &student->gpa, &student->status, &student->toefl
+	};
+
+	*copy = *student;
+	ss_Slice_t *to[] = {
+		&copy->first_name, &copy->last_name, &copy->birth_month, &copy->birth_day,
+		&copy->birth_year, &copy->gpa, &copy->status, &copy->toefl
+	};
+	size_t offset = 0;
+	for (int i = 0; i < 8; i++) {
+		if (from[i]->text == NULL) continue;
+		memcpy(text + offset, from[i]->text, from[i]->length);
+		*to[i] = makeSlice(text + offset, from[i]->length);
+		offset += from[i]->length;
+	}
+	copy->last_rank = SS_RANK_NONE;
+	copy->first_rank = SS_RANK_NONE;
+}
+
+/**
+ * Function to copy a student into a top entry.
+ * The text is copied too, as the input it points to may be reused.
+ * Returns false if memory could not be allocated, leaving the entry as it was.
+ */
+static bool copyToEntry(TopEntry_t *entry, ss_Student_t *student, uint64_t sequence) {
+	size_t total = studentTextLength(student);
+	if (total > entry->text_size) {
+		char *temp = (char *) reallocate(entry->text, total);
+		if (temp == NULL) return false;
+		entry->text = temp;
+		entry->text_size = total;
+	}
+
+	copyStudent(&entry->student, student, entry->text);
+	entry->sequence = sequence;
+	return true;
+}
+
+/**
+ * Function to move an entry down the top heap to its place.
+ */
+static void siftTopDown(TopList_t *top, size_t index) {
+	while (true) {
+		size_t largest = index;
+		size_t left = index * 2 + 1;
+		size_t right = left + 1;
+		TopEntry_t *entries = top->entries;
+		if (left < top->count && topAfter(&entries[top->heap[left]], &entries[top->heap[largest]])) largest = left;
+		if (right < top->count && topAfter(&entries[top->heap[right]], &entries[top->heap[largest]])) largest = right;
+		if (largest == index) return;
+
+		size_t swap = top->heap[index];
+		top->heap[index] = top->heap[largest];
+		top->heap[largest] = swap;
+		index = largest;
+	}
+}
+
+/**
+ * Function to offer a student to the top list.
+ * Kept if the list is not full or it goes before the last kept student.
+ */
+static bool offerTop(TopList_t *top, ss_Student_t *student, ss_Result_t *result) {
+	// Only students of the chosen list
+	if (top->option == 1 && student->status_value != SS_STATUS_DOMESTIC) return true;
+	if (top->option == 2 && student->status_value != SS_STATUS_INTERNATIONAL) return true;
+	uint64_t sequence = top->sequence++;
+
+	if (top->count < top->limit) {
+		if (top->count == top->capacity && !growTopList(top))
+			return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+		TopEntry_t *entry = &top->entries[top->count];
+		if (!copyToEntry(entry, student, sequence))
+			return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+
+		// Move up the heap to its place
+		size_t index = top->count++;
+		while (index > 0 && topAfter(entry, &top->entries[top->heap[(index - 1) / 2]])) {
+			top->heap[index] = top->heap[(index - 1) / 2];
+			index = (index - 1) / 2;
+		}
+		top->heap[index] = (size_t) (entry - top->entries);
+		return true;
+	}
+
+	// Replace the last kept student. Ties lose, as they came later.
+	if (ss_compareStudents(student, &top->entries[top->heap[0]].student) >= 0) return true;
+	if (!copyToEntry(&top->entries[top->heap[0]], student, sequence))
+		return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+	siftTopDown(top, 0);
+	return true;
+}
+
+/**
+ * Function to get the node after a node on a level of the index.
+ * Level 0 is the list node, so the index reads as a sorted list.
+ */
+static IndexNode_t *nextAt(IndexNode_t *node, int level) {
+	if (level == 0) return (IndexNode_t *) node->node.next;
+	return node->forward[level - 1];
+}
+
+/**
+ * Function to set the node after a node on a level of the index.
+ */
+static void setNextAt(IndexNode_t *node, int level, IndexNode_t *next) {
+	if (level == 0) node->node.next = (next != NULL) ? &next->node : NULL;
+	else node->forward[level - 1] = next;
+}
+
+/**
+ * Function to get the bytes of an index node of a height.
+ */
+static size_t indexNodeSize(int height) {
+	return sizeof(IndexNode_t) + sizeof(IndexNode_t *) * (size_t) (height - 1);
+}
+
+/**
+ * Function to pick the height of a new index node, using xorshift64*.
+ * Each level is taken with a chance of one in four.
+ */
+static int randomHeight(ss_StudentIndex_t *index) {
+	index->random ^= index->random >> 12;
+	index->random ^= index->random << 25;
+	index->random ^= index->random >> 27;
+	uint64_t bits = index->random * 0x2545F4914F6CDD1DULL;
+
+	int height = 1;
+	while (height < INDEX_MAX_HEIGHT && (bits & 3) == 0) {
+		height++;
+		bits >>= 2;
+	}
+	return height;
+}
+
+/**
+ * Function to find the last node before a student on every level.
+ * With after_equal, nodes equal to the student count as before it, so a new
+ * student goes after its equals. Levels above the index get the head.
+ */
+static void findBefore(ss_StudentIndex_t *index, ss_Student_t *student, IndexNode_t **before, bool after_equal) {
+	IndexNode_t *current = index->head;
+	for (int level = INDEX_MAX_HEIGHT - 1; level >= index->height; level--) before[level] = current;
+
+	for (int level = index->height - 1; level >= 0; level--) {
+		IndexNode_t *next = nextAt(current, level);
+		while (next != NULL) {
+			int order = ss_compareStudents(next->node.student, student);
+			if (order > 0 || (order == 0 && !after_equal)) break;
+			current = next;
+			next = nextAt(current, level);
+		}
+		before[level] = current;
+	}
+}
+
+/**
+ * Function to load the students of a list into a new index.
+ */
+ss_StudentIndex_t *ss_createIndex(const ss_StudentList_t *list, ss_Result_t *result) {
+	ss_StudentIndex_t *index = (ss_StudentIndex_t *) allocateZeroed(1, sizeof(ss_StudentIndex_t));
+	if (index == NULL) {
+		setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+		return NULL;
+	}
+	index->height = 1;
+	index->random = 0x9E3779B97F4A7C15ULL;
+	index->head = (IndexNode_t *) arenaAlloc(&index->arena, indexNodeSize(INDEX_MAX_HEIGHT), _Alignof(IndexNode_t));
+	if (index->head == NULL) {
+		ss_freeIndex(index);
+		setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+		return NULL;
+	}
+	memset(index->head, 0, indexNodeSize(INDEX_MAX_HEIGHT));
+	index->head->height = INDEX_MAX_HEIGHT;
+
+	// Sort copies of the nodes, so the list keeps its order and its tails
+	size_t count = 0;
+	for (ss_ListNode_t *current = list->head_a; current != NULL; current = current->next) count++;
+	ss_ListNode_t *copies = NULL;
+	if (count != 0) {
+		copies = (ss_ListNode_t *) allocate(sizeof(ss_ListNode_t) * count);
+		if (copies == NULL) {
+			ss_freeIndex(index);
+			setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+			return NULL;
+		}
+		size_t i = 0;
+		for (ss_ListNode_t *current = list->head_a; current != NULL; current = current->next, i++) {
+			copies[i].student = current->student;
+			copies[i].next = (i + 1 < count) ? &copies[i + 1] : NULL;
+		}
+	}
+	ss_ListNode_t *sorted = copies;
+	tableSortList(&sorted);
+
+	// Append in order. Every fourth node is a level taller, so the index starts balanced.
+	IndexNode_t *tails[INDEX_MAX_HEIGHT];
+	for (int level = 0; level < INDEX_MAX_HEIGHT; level++) tails[level] = index->head;
+	for (ss_ListNode_t *current = sorted; current != NULL; current = current->next) {
+		int height = 1;
+		for (size_t position = index->count + 1; height < INDEX_MAX_HEIGHT && position % 4 == 0; position /= 4) height++;
+
+		IndexNode_t *node = (IndexNode_t *) arenaAlloc(&index->arena, indexNodeSize(height), _Alignof(IndexNode_t));
+		if (node == NULL) {
+			free(copies);
+			ss_freeIndex(index);
+			setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+			return NULL;
+		}
+		node->node.student = current->student;
+		node->owned = false;
+		node->height = (uint8_t) height;
+		for (int level = 0; level < height; level++) {
+			setNextAt(node, level, NULL);
+			setNextAt(tails[level], level, node);
+			tails[level] = node;
+		}
+		if (height > index->height) index->height = height;
+		index->count++;
+	}
+	free(copies);
+	return index;
+}
+
+/**
+ * Function to add a copy of a student to an index.
+ */
+bool ss_insertStudent(ss_StudentIndex_t *index, const ss_Student_t *student, ss_Result_t *result) {
+	int height = randomHeight(index);
+	size_t student_offset = (indexNodeSize(height) + _Alignof(ss_Student_t) - 1) / _Alignof(ss_Student_t) * _Alignof(ss_Student_t);
+	char *memory = (char *) allocate(student_offset + sizeof(ss_Student_t) + studentTextLength(student));
+	if (memory == NULL) return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+
+	// The node, its copy of the student and the text are freed together
+	IndexNode_t *node = (IndexNode_t *) memory;
+	ss_Student_t *copy = (ss_Student_t *) (memory + student_offset);
+	copyStudent(copy, student, memory + student_offset + sizeof(ss_Student_t));
+	node->node.student = copy;
+	node->owned = true;
+	node->height = (uint8_t) height;
+
+	IndexNode_t *before[INDEX_MAX_HEIGHT];
+	findBefore(index, copy, before, true);
+	for (int level = 0; level < height; level++) {
+		setNextAt(node, level, nextAt(before[level], level));
+		setNextAt(before[level], level, node);
+	}
+	if (height > index->height) index->height = height;
+	index->count++;
+	return true;
+}
+
+/**
+ * Function to remove the first student of an index equal to a student.
+ */
+bool ss_removeStudent(ss_StudentIndex_t *index, const ss_Student_t *student) {
+	// Compare by text, as the student may come from another list
+	ss_Student_t key = *student;
+	key.last_rank = SS_RANK_NONE;
+	key.first_rank = SS_RANK_NONE;
+
+	IndexNode_t *before[INDEX_MAX_HEIGHT];
+	findBefore(index, &key, before, false);
+	IndexNode_t *node = nextAt(before[0], 0);
+	if (node == NULL || ss_compareStudents(node->node.student, &key) != 0) return false;
+
+	for (int level = 0; level < node->height; level++) setNextAt(before[level], level, nextAt(node, level));
+	while (index->height > 1 && nextAt(index->head, index->height - 1) == NULL) index->height--;
+	if (node->owned) free(node);
+	index->count--;
+	return true;
+}
+
+/**
+ * Function to get the students of an index in sort order.
+ */
+ss_ListNode_t *ss_indexList(const ss_StudentIndex_t *index) {
+	return index->head->node.next;
+}
+
+/**
+ * Function to count the students of an index.
+ */
+size_t ss_indexCount(const ss_StudentIndex_t *index) {
+	return index->count;
+}
+
+/**
+ * Function to free an index and the students added to it.
+ */
+void ss_freeIndex(ss_StudentIndex_t *index) {
+	if (index == NULL) return;
+	if (index->head != NULL) {
+		IndexNode_t *current = nextAt(index->head, 0);
+		while (current != NULL) {
+			IndexNode_t *next = nextAt(current, 0);
+			if (current->owned) free(current);
+			current = next;
+		}
+	}
+	freeArena(&index->arena);
+	free(index);
+}
+
+/**
+ * Function to check if valid name.
+ * Valid name contains letters.
+ * Checks first last name.
+ *
+ * Every add function validates a '\0' terminated copy of the word and
+ * stores slices of source, where the same text is kept for output.
+ * Returns false with the error in result if the word is not valid.
+ */
+static bool addFirstName(char *name, const char *source, ss_Student_t *node, ss_Result_t *result) {
+	const char *error_message = "Error: Invalid first name.";
+
+	// If the name does not contain letters, error.
+	for (int i = 0; i < strlen(name); i++)
+		if (!isalpha(name[i])) return setError(result, SS_RESULT_INVALID_INPUT, error_message);
+
+	node->first_name = makeSlice(source, strlen(name));
+	return true;
+}
+
+/**
+ * Function to check if valid name.
+ * Valid name contains letters.
+ * Checks last name.
+ */
+static bool addLastName(char *name, const char *source, ss_Student_t *node, ss_Result_t *result) {
+	const char *error_message = "Error: Invalid last name.";
+
+	// If the name does not contain letters, error.
+	for (int i = 0; i < strlen(name); i++)
+		if (!isalpha(name[i])) return setError(result, SS_RESULT_INVALID_INPUT, error_message);
+
+	node->last_name = makeSlice(source, strlen(name));
+	return true;
+}
+
+/**
+ * Function to find the index of a month from its text.
+ * Returns SS_MONTH_NONE if the text is not one of months.
+ */
+static uint8_t monthIndex(const char *text, size_t length) {
+	if (length != 3) return SS_MONTH_NONE;
+	uint8_t index = month_hash[((unsigned char) text[1] + (unsigned char) text[2]) & 31];
+	if (index == SS_MONTH_NONE || memcmp(text, months[index], 3) != 0) return SS_MONTH_NONE;
+	return index;
+}
+
+/**
+ * Function to check if valid date.
+ * Valid date contains numbers.
+ * Checks month, day, and year.
+ */
+static bool addDate(char *date, const char *source, ss_Student_t *node, ss_Result_t *result) {
+	// Delimit each dash e.g., Month-Day-Year
+	int counter = 0;
+	char *delimiter = "-";
+	char *ptr;
+	char *data = strtok_r(date, delimiter, &ptr); 
+	char *end_ptr;
+
+	while (data != NULL) {
+		counter++;
+		switch (counter) {
+			case 1: // Month
+				// Check if equals to one of the months
+				node->month_index = monthIndex(data, strlen(data));
+				if (node->month_index == SS_MONTH_NONE) return setError(result, SS_RESULT_INVALID_INPUT, "Error: Invalid month.");
+				node->birth_month = makeSlice(source + (data - date), strlen(data));
+				break;
+			case 2: // Day
+				// Check if number and not other characters
+				if (data[0] == '0') return setError(result, SS_RESULT_INVALID_INPUT, "Error: Invalid day."); // If leading zero, error
+				long day = strtol(data, &end_ptr, 10); // Convert string to int
+				
+				// Check if number is between 1 and 31
+				if (*end_ptr != '\0' || day < 1 || day > 31) return setError(result, SS_RESULT_INVALID_INPUT, "Error: Invalid day.");
+				node->day_value = (uint8_t) day;
+				node->birth_day = makeSlice(source + (data - date), strlen(data));
+				break;
+			case 3: // Year
+				// Check if number and not other characters
+				if (data[0] == '0') return setError(result, SS_RESULT_INVALID_INPUT, "Error: Invalid year."); // If leading zero, error
+				long year = strtol(data, &end_ptr, 10); // Convert string to int
+				
+				// Check if number is between 1950 and 2010
+				if (*end_ptr != '\0' || year < 1950 || year > 2010) return setError(result, SS_RESULT_INVALID_INPUT, "Error: Invalid year.");
+				node->year_value = (uint16_t) year;
+				node->birth_year = makeSlice(source + (data - date), strlen(data));
+				break;
+			default:
+				return setError(result, SS_RESULT_INVALID_INPUT, "Error: Invalid date format.");
+		}
+		data = strtok_r(NULL, delimiter, &ptr); // Gets the next string
+	}
+	return true;
+}
+
+/**
+ * Function to check if valid GPA.
+ */
+static bool addGPA(char *gpa, const char *source, ss_Student_t *node, ss_Result_t *result) {
+	const char *error_message = "Error: Invalid GPA.";
+	if (gpa[0] == '0' && gpa[1] != '.') return setError(result, SS_RESULT_INVALID_INPUT, error_message); // If leading zero, error
+
+	// Only a sign, digits and a point, since an exponent e.g., "1e-5" or "15e-5" holds more decimals than are stored
+	const char *digits = gpa + (gpa[0] == '+' || gpa[0] == '-');
+	if (digits[strspn(digits, "0123456789.")] != '\0') return setError(result, SS_RESULT_INVALID_INPUT, error_message);
+
+	char *ptr;
+	double val = strtod(gpa, &ptr); // Convert string to double
+
+	if (*ptr != '\0') return setError(result, SS_RESULT_INVALID_INPUT, error_message); // If there is a character, error
+	if (!(val >= 0.0 && val <= 4.3)) return setError(result, SS_RESULT_INVALID_INPUT, error_message); // If out of range, error
+	if (strlen(gpa) > 5) return setError(result, SS_RESULT_INVALID_INPUT, error_message); // If more than 3 decimal places, error
+
+	// Five characters allow up to four decimals e.g., ".1234", so ten-thousandths keep every GPA exact
+	node->gpa_value = (uint16_t) (val * 10000.0 + 0.5);
+	node->gpa = makeSlice(source, strlen(gpa));
+	return true;
+}
+
+/**
+ * Function to check if valid status.
+ * Valid status is either D or I.
+ */
+static bool addStatus(char *status, const char *source, ss_Student_t *node, ss_Result_t *result) {
+	const char *error_message = "Error: Invalid status.";
+	if (status == NULL || (strcmp(status, "D") != 0 && strcmp(status, "I") != 0)) return setError(result, SS_RESULT_INVALID_INPUT, error_message);
+
+	node->status_value = (status[0] == 'D') ? SS_STATUS_DOMESTIC : SS_STATUS_INTERNATIONAL;
+	node->status = makeSlice(source, strlen(status));
+	return true;
+}
+
+/**
+ * Function to check if valid TOEFL.
+ * Valid TOEFL is between 0 and 120.
+ */
+static bool addTOEFL(char *toefl, const char *source, ss_Student_t *node, ss_Result_t *result) {
+	const char *error_message = "Error: Invalid TOEFL.";
+	
+	if (node->status_value == SS_STATUS_DOMESTIC && toefl != NULL) return setError(result, SS_RESULT_INVALID_INPUT, error_message);
+	if (node->status_value == SS_STATUS_INTERNATIONAL && toefl == NULL) return setError(result, SS_RESULT_INVALID_INPUT, error_message);
+
+	if (toefl != NULL) {
+		if (toefl[0] == '0' && toefl[1] == '0') return setError(result, SS_RESULT_INVALID_INPUT, error_message);
+
+		char *end_ptr;
+		long val = strtol(toefl, &end_ptr, 10); // Convert string to int
+	
+		if (*end_ptr != '\0' || val < 0 || val > 120) return setError(result, SS_RESULT_INVALID_INPUT, error_message); // If out of range, error
+
+		node->toefl_value = (uint8_t) val;
+		node->toefl = makeSlice(source, strlen(toefl));
+	}
+	return true;
+}
+
+/**
+ * Function to process word into Student struct.
+ * Returns false with the error in result if the word is not valid.
+ */
+static bool processWord(char *word, const char *source, ss_Student_t *current, int word_count, ss_Result_t *result) {
+	switch (word_count) {
+		case 1: return addFirstName(word, source, current, result);
+		case 2: return addLastName(word, source, current, result);
+		case 3: return addDate(word, source, current, result);
+		case 4: return addGPA(word, source, current, result);
+		case 5: return addStatus(word, source, current, result);
+		case 6: return addTOEFL(word, source, current, result);
+		default: return setError(result, SS_RESULT_INVALID_INPUT, "Error: Incorrect input format.");
+	}
+}
+
+/**
+ * Function to map a regular input file into memory.
+ * Returns false if the file cannot be mapped, e.g. a pipe or an empty file.
+ */
+static bool mapInput(Input_t *input) {
+	struct stat info;
+	int fd = fileno(input->file);
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) return false;
+
+	void *data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) return false;
+	madvise(data, (size_t) info.st_size, MADV_SEQUENTIAL);
+
+	input->data = (const char *) data;
+	input->length = (size_t) info.st_size;
+	input->position = 0;
+	return true;
+}
+
+/**
+ * Function to unmap the input file.
+ * Students read from a mapped file point into it, so call after writing.
+ */
+static void unmapInput(Input_t *input) {
+	if (input->data != NULL) munmap((void *) input->data, input->length);
+	input->data = NULL;
+}
+
+/**
+ * Function to close the input file and unmap it.
+ */
+static void closeInput(Input_t *input) {
+	if (input->file != NULL) fclose(input->file);
+	input->file = NULL;
+	unmapInput(input);
+	free(input->buffer);
+	input->buffer = NULL;
+	input->buffer_size = 0;
+}
+
+/**
+ * Function to get the next character of the input.
+ * Same as fgetc, including EOF at the end.
+ * Position counts the bytes read from a stream too.
+ */
+static int nextChar(Input_t *input) {
+	if (input->data == NULL) {
+		int c = fgetc(input->file);
+		if (c != EOF) input->position++;
+		return c;
+	}
+	if (input->position < input->length) return (unsigned char) input->data[input->position++];
+	return EOF;
+}
+
+/**
+ * Function to classify the bytes of a block one at a time.
+ * Used when there is no vector scanner, and for the last bytes of the input.
+ */
+static void scanBlockScalar(const char *block, size_t length, BlockMasks_t *masks) {
+	masks->newlines = masks->spaces = masks->others = 0;
+	for (size_t i = 0; i < length; i++) {
+		unsigned char byte = (unsigned char) block[i];
+		if (byte == '\n') masks->newlines |= 1u << i;
+		else if (byte == ' ') masks->spaces |= 1u << i;
+		else if ((byte >= '\t' && byte <= '\r') || byte == 0 || byte >= 0x80) masks->others |= 1u << i;
+	}
+}
+
+#ifdef SCAN_X86
+/**
+ * Function to classify a block of SCAN_BLOCK bytes with SSE2, 16 at a time.
+ */
+static void scanBlockSSE2(const char *block, size_t length, BlockMasks_t *masks) {
+	(void) length;
+	masks->newlines = masks->spaces = masks->others = 0;
+	for (int half = 0; half < 2; half++) {
+		__m128i bytes = _mm_loadu_si128((const __m128i *) (block + half * 16));
+		uint32_t newlines = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+		uint32_t spaces = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')));
+
+		// '\t' to '\r' are the bytes whose distance from '\t' is at most 4
+		__m128i distance = _mm_sub_epi8(bytes, _mm_set1_epi8('\t'));
+		__m128i control = _mm_cmpeq_epi8(_mm_min_epu8(distance, _mm_set1_epi8(4)), distance);
+		__m128i zero = _mm_cmpeq_epi8(bytes, _mm_setzero_si128());
+		uint32_t others = (uint32_t) (_mm_movemask_epi8(_mm_or_si128(control, zero)) | _mm_movemask_epi8(bytes));
+
+		masks->newlines |= newlines << (half * 16);
+		masks->spaces |= spaces << (half * 16);
+		masks->others |= (others & ~newlines) << (half * 16);
+	}
+}
+
+/**
+ * Function to classify a block of SCAN_BLOCK bytes with AVX2, all at once.
+ */
+__attribute__((target("avx2")))
+static void scanBlockAVX2(const char *block, size_t length, BlockMasks_t *masks) {
+	(void) length;
+	__m256i bytes = _mm256_loadu_si256((const __m256i *) block);
+	uint32_t newlines = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+	uint32_t spaces = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')));
+
+	__m256i distance = _mm256_sub_epi8(bytes, _mm256_set1_epi8('\t'));
+	__m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(distance, _mm256_set1_epi8(4)), distance);
+	__m256i zero = _mm256_cmpeq_epi8(bytes, _mm256_setzero_si256());
+	uint32_t others = (uint32_t) (_mm256_movemask_epi8(_mm256_or_si256(control, zero)) | _mm256_movemask_epi8(bytes));
+
+	masks->newlines = newlines;
+	masks->spaces = spaces;
+	masks->others = others & ~newlines;
+}
+#endif
+
+// Scanner for whole blocks, picked by selectScanner
+static void (*scanBlock)(const char *block, size_t length, BlockMasks_t *masks) = scanBlockScalar;
+static pthread_once_t scanner_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Function to pick the fastest scanner the processor supports.
+ */
+static void selectScanner(void) {
+#ifdef SCAN_X86
+	__builtin_cpu_init();
+	scanBlock = __builtin_cpu_supports("avx2") ? scanBlockAVX2 : scanBlockSSE2;
+#endif
+}
+
+/**
+ * Function to find the end of the line at text and the spaces in it.
+ * Stops at the first '\n', or at end if there is none.
+ */
+static void scanLine(const char *text, const char *end, LineScan_t *scan) {
+	size_t offset = 0;
+	scan->found = false;
+	scan->spaces = 0;
+	scan->others = 0;
+	scan->other_at = 0;
+
+	while (text + offset < end) {
+		size_t length = (size_t) (end - (text + offset));
+		BlockMasks_t masks;
+		if (length >= SCAN_BLOCK) {
+			length = SCAN_BLOCK;
+			scanBlock(text + offset, length, &masks);
+		} else {
+			scanBlockScalar(text + offset, length, &masks);
+		}
+
+		// Only bytes before the newline belong to the line
+		if (masks.newlines != 0) {
+			uint32_t before = (masks.newlines & -masks.newlines) - 1;
+			masks.spaces &= before;
+			masks.others &= before;
+		}
+		if (masks.others != 0) {
+			if (scan->others == 0) scan->other_at = offset + (size_t) __builtin_ctz(masks.others);
+			scan->others += __builtin_popcount(masks.others);
+		}
+		for (uint32_t spaces = masks.spaces; spaces != 0; spaces &= spaces - 1) {
+			if (scan->spaces < 6) scan->space_at[scan->spaces] = (uint32_t) (offset + (size_t) __builtin_ctz(spaces));
+			scan->spaces++;
+		}
+		if (masks.newlines != 0) {
+			scan->length = offset + (size_t) __builtin_ctz(masks.newlines);
+			scan->found = true;
+			return;
+		}
+		offset += length;
+	}
+	scan->length = offset;
+}
+
+/**
+ * Function to validate a word and store it in the student.
+ * Names are interned, unless the student is for the top list.
+ * Returns false with the error in result if the word is not valid.
+ */
+static bool storeWord(ss_StudentList_t *list, ss_Student_t *current, char *word, const char *source, int word_count,
+	bool copied, ArenaMark_t word_mark, ss_Result_t *result) {
+	if (!processWord(word, source, current, word_count, result)) return false;
+
+	// Store each distinct name once. Students for the top list are copied instead.
+	if (word_count <= 2 && list->top == NULL) {
+		ss_Slice_t *name = (word_count == 1) ? &current->first_name : &current->last_name;
+		uint32_t *rank = (word_count == 1) ? &current->first_rank : &current->last_rank;
+		if (!internName(list, name, rank, copied, word_mark))
+			return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+	}
+	return true;
+}
+
+/**
+ * Function to read a whole line of mapped input at once, if it is plain.
+ *
+ * A plain line is up to six words of printable ASCII split by single spaces,
+ * ending in "\n" or "\r\n". Its words give the same student and the same
+ * errors as reading it character by character. Any other line, including
+ * one without a newline at the end of the input, is left to readLines,
+ * which finds its format errors.
+ *
+ * Sets plain if the line was read. Returns false with the error in result
+ * if a word is not valid.
+ */
+static bool readPlainLine(Input_t *input, ss_StudentList_t *list, ss_Student_t *current, char *encoding, size_t line,
+	bool *plain, ss_Result_t *result) {
+	*plain = false;
+	const char *text = input->data + input->position;
+	LineScan_t scan;
+	scanLine(text, input->data + input->length, &scan);
+
+	size_t length = scan.length;
+	bool windows = false;
+	if (!scan.found || length == 0) return true;
+	if (scan.others != 0) {
+		// A '\r' right before the '\n' is the only other byte allowed
+		if (scan.others != 1 || scan.other_at != length - 1 || text[length - 1] != '\r') return true;
+		windows = true;
+		length--;
+	}
+	if (length == 0 || scan.spaces > 5 || text[0] == ' ' || text[length - 1] == ' ') return true;
+	for (int i = 1; i < scan.spaces; i++)
+		if (scan.space_at[i] == scan.space_at[i - 1] + 1) return true;
+
+	// Words end at each space, and the last one at the end of the line
+	for (int i = 0; i <= scan.spaces; i++) {
+		size_t begin = (i == 0) ? 0 : scan.space_at[i - 1] + 1;
+		size_t end = (i == scan.spaces) ? length : scan.space_at[i];
+		size_t word_length = end - begin;
+
+		if (word_length + 1 > (size_t) input->buffer_size) { // Reallocate memory if word is too long
+			int size = input->buffer_size;
+			while ((size_t) size < word_length + 1) size *= 2;
+			char *temp = (char *) reallocate(input->buffer, sizeof(char) * size);
+			if (temp == NULL) return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+			input->buffer = temp;
+			input->buffer_size = size;
+		}
+		memcpy(input->buffer, text + begin, word_length);
+		input->buffer[word_length] = '\0';
+
+		if (!storeWord(list, current, input->buffer, text + begin, i + 1, false, markArena(&list->arena), result)) {
+			if (result->code == SS_RESULT_INVALID_INPUT) {
+				result->line = line;
+				result->column = begin + 1;
+			}
+			return false;
+		}
+	}
+
+	if (windows) *encoding = 'W';
+	input->position += scan.length + 1;
+	*plain = true;
+	return true;
+}
+
+/**
+ * Function to keep the student of a line that was read.
+ * Appends it to the list, or offers it to the top list and reuses the node.
+ * Sets full once the arena of the list passes the budget, and then leaves
+ * current as it is rather than creating the next node.
+ */
+static bool keepStudent(ss_StudentList_t *list, ss_Student_t **current, ArenaMark_t line_mark, size_t budget, bool *full,
+	ss_Result_t *result) {
+	list->count_a++;
+	if ((*current)->status_value == SS_STATUS_DOMESTIC) list->count_d++;
+	else if ((*current)->status_value == SS_STATUS_INTERNATIONAL) list->count_i++;
+
+	if (list->top != NULL) {
+		// Offer to the top list, then reuse the node and the arena for the next line
+		if (!offerTop(list->top, *current, result)) return false;
+		resetNode(*current);
+		releaseArena(&list->arena, line_mark);
+		return true;
+	}
+
+	// Append Student to linked list
+	if (!appendList(list, *current, result)) return false;
+	*full = (budget != 0 && list->arena.allocated >= budget);
+	if (!*full) *current = createNode(list);
+	if (*current == NULL) return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+	return true;
+}
+
+/**
+ * Function to read the lines of the input file into the list.
+ * Names of students kept in the list are interned, and hold ids, not ranks.
+ *
+ * Plain lines of mapped input are read a line at a time by readPlainLine.
+ * Every other line is read a character at a time, checking its format.
+ */
+static bool readLines(Input_t *input, ss_StudentList_t *list, const int option, char *encoding, size_t budget, bool *more, ss_Result_t *result) {
+	*more = false;
+	if (input == NULL || (input->file == NULL && input->data == NULL)) // Error handle reading file
+		return setError(result, SS_RESULT_IO, "Error: Could not read file.");
+
+	const char *memory_error = "Error: Memory could not be allocated.";
+	ss_Student_t *current = createNode(list);
+	if (current == NULL) return setError(result, SS_RESULT_NO_MEMORY, memory_error);
+	ArenaMark_t line_mark = markArena(&list->arena); // Start of the words of a line
+	if (input->buffer == NULL) {
+		input->buffer_size = 20;
+		input->buffer = (char *) allocate(sizeof(char) * input->buffer_size);
+		if (input->buffer == NULL) return setError(result, SS_RESULT_NO_MEMORY, memory_error);
+	}
+	int size = input->buffer_size;
+	char *buffer = input->buffer;
+	pthread_once(&scanner_once, selectScanner);
+
+	char c;
+	char last_char = 0;
+	char *word = buffer; // Pointer to buffer
+	const char *source = NULL; // Start of the word in the mapped file
+	size_t characters = input->characters;
+	size_t line = input->lines + 1; // Line being read, for errors
+	size_t column = 0; // Character of the line being read
+	size_t word_column = 0; // Character the word being read starts at
+	bool full = false;
+	int word_count = 0;
+	int word_length = 0;
+	int space_count = 0;
+	bool in_word = false;
+
+	while (true) {
+		// At the start of a line of mapped input, try to read it all at once
+		if (input->data != NULL && column == 0) {
+			bool plain;
+			size_t start = input->position;
+			if (!readPlainLine(input, list, current, encoding, line, &plain, result)) return false;
+			if (plain) {
+				buffer = input->buffer;
+				size = input->buffer_size;
+				word = buffer;
+				if (!keepStudent(list, &current, line_mark, budget, &full, result)) return false;
+				input->lines++;
+				line++;
+				characters += input->position - start;
+				if (full) break;
+				continue;
+			}
+		}
+
+		if ((c = nextChar(input)) == EOF) break;
+		column++;
+		if (input->data == NULL && ferror(input->file)) // Error handle reading file
+			return setError(result, SS_RESULT_IO, "Error: Could not read file.");
+		if (space_count > 1) // Error handle consecutive spaces
+			return setInputError(result, "Error: Consecutive spaces is invalid format.", line, column);
+		if (word_count > 6) // Error handle too many words
+			return setInputError(result, "Error: Too many fields.", line, column);
+		if (word_length >= (size - 1)) { // Reallocate memory if word is too long
+			size *= 2;
+			char *temp = (char *) reallocate(buffer, sizeof(char) * size);
+			if (temp == NULL) return setError(result, SS_RESULT_NO_MEMORY, memory_error);
+			buffer = temp;
+			input->buffer = buffer;
+			input->buffer_size = size;
+			word = buffer + word_length; // Continue building string from last char
+		}
+
+		if (!isspace(c)) {
+			if (!in_word) { // Start of word 
+				word_count++;
+				space_count = 0;
+				in_word = true;
+				word_column = column;
+				if (input->data != NULL) source = input->data + input->position - 1;
+			}
+			*word++ = c;
+			word_length++;
+		} else if (isspace(c)) {
+			if (c != '\r' && c != '\n' && word_count == 0) // Error handle leading spaces
+				return setInputError(result, "Error: Leading spaces is invalid format.", line, column);
+		
+			if (in_word) { // End of word
+				*word = '\0';
+				// Words read from a stream have nowhere to live, so keep a copy in the arena
+				ArenaMark_t word_mark = markArena(&list->arena);
+				if (input->data == NULL) source = arenaCopy(&list->arena, buffer, word_length);
+				if (source == NULL) return setError(result, SS_RESULT_NO_MEMORY, memory_error);
+				if (!storeWord(list, current, buffer, source, word_count, input->data == NULL, word_mark, result)) { // Process word
+					if (result->code == SS_RESULT_INVALID_INPUT) {
+						result->line = line;
+						result->column = word_column;
+					}
+					return false;
+				}
+				word = buffer; // Reset word
+				memset(buffer, 0, 20); // Reset buffer
+				word_length = 0;
+				in_word = false;
+			}
+			if (c == '\r' ) {
+				*encoding = 'W';
+				char next_char = nextChar(input); // Peek next character
+				if (next_char != '\n')
+					return setInputError(result, "Error: Carriage return is invalid format.", line, column + 1);
+			}
+			space_count++;
+		}
+		// Reset word count if end of line
+		if ((c == '\r' || c == '\n') && space_count != 0) {
+			// Error handle empty line
+			// Only last line can be empty
+			if (word_count == 0) {
+				last_char = (char) c;
+				char next_char = nextChar(input); // Peek next character
+				if (next_char == EOF && characters != 0) break;
+				else return setInputError(result, "Error: Empty line is invalid format.", line, column);
+			}
+
+			// Error handle trailing spaces
+			if (space_count > 1) return setInputError(result, "Error: Trailing spaces is invalid format.", line, column);
+
+			if (!keepStudent(list, &current, line_mark, budget, &full, result)) return false;
+
+			// Reset counts for next line
+			word_count = 0;
+			space_count = 0;
+			input->lines++;
+			line++;
+			column = 0;
+		}
+		characters++;
+		if (full) break; // Stop between lines, the next call starts a fresh line
+	} // End of while loop
+	input->characters = characters;
+	if (full) {
+		*more = true;
+		return true;
+	}
+	if (last_char != 0 && last_char != '\r' && last_char != '\n')
+		return setInputError(result, "Error: Last line is invalid format.", line, column);
+	return true;
+}
+
+/**
+ * Function to read text from input file. 
+ * Reads from the mapped file when there is one, otherwise with fgetc.
+ *
+ * With a budget, stops at the end of the first line after the arena of the
+ * list grows past budget bytes and sets more. Call again to read on.
+ * Clears more once the whole file is read.
+ *
+ * Names are ranked afterwards, even on error, so the students in the list
+ * can always be sorted.
+ *
+ * Returns false if the input is not valid. The result then holds the line
+ * and column of the error, and the list holds the students read before it.
+ */ 
+static bool readFile(Input_t *input, ss_StudentList_t *list, const int option, char *encoding, size_t budget, bool *more, ss_Result_t *result) {
+	unrankStudents(list);
+	bool read = readLines(input, list, option, encoding, budget, more, result);
+	rankStudents(list);
+	return read;
+}
+
+/**
+ * Function to read one chunk of the input on a thread.
+ */
+static void *parsePart(void *arg) {
+	ParseTask_t *task = (ParseTask_t *) arg;
+	Counters_t before = counters;
+	bool more;
+
+	task->read = readLines(&task->input, &task->list, task->option, &task->encoding, 0, &more, &task->result);
+	task->work.allocations = counters.allocations - before.allocations;
+	return NULL;
+}
+
+/**
+ * Function to find where the chunk of the input after begin can start.
+ * A chunk starts after a '\n' and must not end in an empty line, as only the
+ * last line of the whole input may be empty.
+ * Returns length if there is no such place.
+ */
+static size_t findChunkStart(const char *data, size_t begin, size_t length) {
+	while (begin < length) {
+		const char *newline = (const char *) memchr(data + begin, '\n', length - begin);
+		if (newline == NULL) return length;
+		begin = (size_t) (newline - data) + 1;
+
+		// Skip the place if the line before it is empty
+		size_t end = begin - 1;
+		if (end > 0 && data[end - 1] == '\r') end--;
+		if (end > 0 && data[end - 1] != '\n') return begin;
+	}
+	return length;
+}
+
+/**
+ * Function to add the students of a chunk to the end of the list.
+ * Turns the name ids of the chunk into ids of the name table of the list,
+ * and moves the arena of the chunk into the arena of the list.
+ * Returns false if memory could not be allocated.
+ */
+static bool joinChunk(ss_StudentList_t *list, ss_StudentList_t *part) {
+	NameTable_t *names = part->names;
+	if (names != NULL && names->count != 0) {
+		if (!createNames(list)) return false;
+		uint32_t *ids = (uint32_t *) allocate(sizeof(uint32_t) * names->count);
+		if (ids == NULL) return false;
+		for (size_t id = 0; id < names->count; id++) {
+			if (!findName(list->names, names->names[id], &ids[id])) {
+				free(ids);
+				return false;
+			}
+		}
+
+		for (ss_ListNode_t *node = part->head_a; node != NULL; node = node->next) {
+			ss_Student_t *student = node->student;
+			if (student->last_rank != SS_RANK_NONE) {
+				student->last_rank = ids[student->last_rank];
+				student->last_name = list->names->names[student->last_rank];
+			}
+			if (student->first_rank != SS_RANK_NONE) {
+				student->first_rank = ids[student->first_rank];
+				student->first_name = list->names->names[student->first_rank];
+			}
+		}
+		free(ids);
+	}
+
+	spliceArena(&list->arena, &part->arena);
+	ss_ListNode_t **heads[] = {&list->head_d, &list->head_i, &list->head_a};
+	ss_ListNode_t **tails[] = {&list->tail_d, &list->tail_i, &list->tail_a};
+	ss_ListNode_t *part_heads[] = {part->head_d, part->head_i, part->head_a};
+	ss_ListNode_t *part_tails[] = {part->tail_d, part->tail_i, part->tail_a};
+	for (int i = 0; i < 3; i++) {
+		if (part_heads[i] == NULL) continue;
+		if (*heads[i] == NULL) *heads[i] = part_heads[i];
+		else (*tails[i])->next = part_heads[i];
+		*tails[i] = part_tails[i];
+	}
+	list->count_d += part->count_d;
+	list->count_i += part->count_i;
+	list->count_a += part->count_a;
+	part->head_d = part->tail_d = NULL;
+	part->head_i = part->tail_i = NULL;
+	part->head_a = part->tail_a = NULL;
+	return true;
+}
+
+/**
+ * Function to read mapped input in chunks, one thread per chunk.
+ *
+ * The input is split after newlines into about equal chunks. Each is read
+ * by readLines into a list of its own, then the lists are joined in input
+ * order, so the list is the same as from readFile. If a chunk has an error,
+ * the error of the first such chunk is returned, with its line counted from
+ * the start of the input, and the list holds the students before it.
+ */
+static bool readChunks(Input_t *input, ss_StudentList_t *list, const int option, char *encoding, int task_count, ss_Result_t *result) {
+	ParseTask_t *tasks = (ParseTask_t *) allocateZeroed(task_count, sizeof(ParseTask_t));
+	if (tasks == NULL) {
+		bool more;
+		return readFile(input, list, option, encoding, 0, &more, result);
+	}
+
+	const char *data = input->data;
+	size_t length = input->length;
+	size_t begin = input->position;
+	int count = 0;
+	while (begin < length && count < task_count) {
+		size_t end = (count == task_count - 1) ? length :
+			findChunkStart(data, begin + (length - begin) / (task_count - count), length);
+		ParseTask_t *task = &tasks[count++];
+
+		// Characters is not 0 after the first chunk, so an empty last line is allowed as in readFile
+		Input_t chunk = {NULL, data + begin, end - begin, 0, input->characters + begin, 0, NULL, 0};
+		task->input = chunk;
+		task->option = option;
+		task->encoding = 'U';
+		begin = end;
+	}
+	runTasks(parsePart, tasks, sizeof(ParseTask_t), count);
+
+	// Join the chunks in order, up to the first one that failed
+	unrankStudents(list);
+	bool read = true;
+	for (int t = 0; t < count; t++) {
+		ParseTask_t *task = &tasks[t];
+		if (read) {
+			if (!joinChunk(list, &task->list)) {
+				read = setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+			} else {
+				if (task->encoding == 'W') *encoding = 'W';
+				if (!task->read) {
+					*result = task->result;
+					if (result->line != 0) result->line += input->lines;
+					read = false;
+				}
+				input->lines += task->input.lines;
+				input->characters += task->input.position;
+				input->position = (size_t) (task->input.data - data) + task->input.position;
+			}
+		}
+		free(task->input.buffer);
+		ss_freeList(&task->list);
+	}
+	rankStudents(list);
+
+	free(tasks);
+	return read;
+}
+
+/**
+ * Function to read the whole input file into the list.
+ * Large mapped files are read in chunks on up to thread_count threads,
+ * everything else by readFile.
+ */
+static bool readInput(Input_t *input, ss_StudentList_t *list, const int option, char *encoding, int thread_count, ss_Result_t *result) {
+	int task_count = 1;
+	if (input->data != NULL && list->top == NULL && input->position == 0) {
+		size_t chunks = input->length / PARSE_GRAIN;
+		task_count = (chunks < (size_t) thread_count) ? (int) chunks : thread_count;
+
+		// A byte of 0xFF reads as EOF and ends the input, which only one reader can see
+		if (task_count > 1 && memchr(input->data, 0xFF, input->length) != NULL) task_count = 1;
+	}
+
+	if (task_count > 1) return readChunks(input, list, option, encoding, task_count, result);
+	bool more;
+	return readFile(input, list, option, encoding, 0, &more, result);
+}
+
+/**
+ * Function to read students from text in memory.
+ * Students point into data, so it must outlive the list.
+ */
+bool ss_parseBuffer(const char *data, size_t length, ss_StudentList_t *list, char *encoding, ss_Result_t *result) {
+	Input_t input = {NULL, (data != NULL) ? data : "", length, 0, 0, 0, NULL, 0};
+	bool more;
+	*encoding = 'U'; // Default encoding is UNIX. Function changes to Windows if needed.
+	bool parsed = readFile(&input, list, 3, encoding, 0, &more, result);
+	free(input.buffer);
+	return parsed;
+}
+
+/**
+ * Function to setup a writer on an open output file.
+ * Nothing may be written to the FILE itself while the writer is in use.
+ */
+static bool initWriter(Writer_t *writer, FILE *output, ss_Result_t *result) {
+	writer->fd = fileno(output);
+	writer->length = 0;
+	writer->size = WRITE_BUFFER_SIZE;
+	writer->buffer = (char *) allocate(writer->size);
+	if (writer->buffer == NULL) return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+	return true;
+}
+
+/**
+ * Function to write out everything in the buffer.
+ */
+static bool flushWriter(Writer_t *writer, ss_Result_t *result) {
+	size_t written = 0;
+	while (written < writer->length) {
+		ssize_t count = write(writer->fd, writer->buffer + written, writer->length - written);
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) return setError(result, SS_RESULT_IO, "Error: Could not write output file.");
+		written += (size_t) count;
+		counters.bytes_written += (uint64_t) count;
+	}
+	writer->length = 0;
+	return true;
+}
+
+/**
+ * Function to flush and free a writer.
+ * The buffer is freed even if the flush fails.
+ */
+static bool freeWriter(Writer_t *writer, ss_Result_t *result) {
+	bool flushed = flushWriter(writer, result);
+	free(writer->buffer);
+	writer->buffer = NULL;
+	return flushed;
+}
+
+/**
+ * Function to copy a field and the character after it into the buffer.
+ * The caller makes sure there is room.
+ */
+static char *putField(char *out, ss_Slice_t field, char after) {
+	memcpy(out, field.text, field.length);
+	out += field.length;
+	if (after != '\0') *out++ = after;
+	return out;
+}
+
+/**
+ * Function to write one student to output file.
+ * Writes by all fields.
+ */
+static bool writeStudent(Writer_t *writer, ss_Student_t *student, const char *encoding, ss_Result_t *result) {
+	ss_Slice_t *fields[] = {
+		&student->first_name, &student->last_name, &student->birth_month, &student->birth_day,
+		&student->birth_year, &student->gpa, &student->status, &student->toefl
+	};
+
+	// Room for every field, its separator and the line ending
+	size_t needed = 8 + 2;
+	for (int i = 0; i < 8; i++) needed += fields[i]->length;
+	if (writer->length + needed > writer->size) {
+		if (writer->fd >= 0 && !flushWriter(writer, result)) return false;
+		if (writer->length + needed > writer->size) {
+			size_t size = writer->size * 2;
+			if (size < writer->length + needed) size = writer->length + needed;
+			char *temp = (char *) reallocate(writer->buffer, size);
+			if (temp == NULL) return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+			writer->buffer = temp;
+			writer->size = size;
+		}
+	}
+
+	char *out = writer->buffer + writer->length;
+	if (student->first_name.text != NULL) out = putField(out, student->first_name, ' ');
+	if (student->last_name.text != NULL) out = putField(out, student->last_name, ' ');
+	if (student->birth_month.text != NULL) out = putField(out, student->birth_month, '-');
+	if (student->birth_day.text != NULL) out = putField(out, student->birth_day, '-');
+	if (student->birth_year.text != NULL) out = putField(out, student->birth_year, ' ');
+	if (student->gpa.text != NULL) out = putField(out, student->gpa, ' ');
+	if (student->status.text != NULL && *student->status.text == 'D') out = putField(out, student->status, '\0');
+	else if (student->status.text != NULL && *student->status.text == 'I') out = putField(out, student->status, ' ');
+	if (student->toefl.text != NULL) out = putField(out, student->toefl, '\0');
+	if (*encoding == 'U') *out++ = '\n';
+	else if (*encoding == 'W') {
+		*out++ = '\r';
+		*out++ = '\n';
+	}
+	writer->length = (size_t) (out - writer->buffer);
+	return true;
+}
+
+/**
+ * Function to write text to output file.
+ * Writes by all fields.
+ * The output file is closed even if writing fails.
+ */
+bool ss_writeFile(FILE *output, ss_ListNode_t *head, const char *encoding, ss_Result_t *result) {
+	Writer_t writer;
+	if (!initWriter(&writer, output, result)) {
+		fclose(output);
+		return false;
+	}
+	bool written = true;
+	for (ss_ListNode_t *current = head; current != NULL && written; current = current->next)
+		written = writeStudent(&writer, current->student, encoding, result);
+	if (written) written = freeWriter(&writer, result);
+	else free(writer.buffer);
+	// Output file must end with a new line
+	// fprintf(output, "\n");
+
+	// Close the output file
+	fclose(output);
+	return written;
+}
+
+/**
+ * Function to write text to memory.
+ * Writes by all fields, the same text ss_writeFile would.
+ * Returns the text, to be freed with free, or NULL if memory ran out.
+ */
+char *ss_serializeList(ss_ListNode_t *head, const char *encoding, size_t *length, ss_Result_t *result) {
+	Writer_t writer;
+	writer.fd = -1;
+	writer.length = 0;
+	writer.size = 4096;
+	writer.buffer = (char *) allocate(writer.size);
+	if (writer.buffer == NULL) {
+		setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+		return NULL;
+	}
+
+	for (ss_ListNode_t *current = head; current != NULL; current = current->next) {
+		if (!writeStudent(&writer, current->student, encoding, result)) {
+			free(writer.buffer);
+			return NULL;
+		}
+	}
+	*length = writer.length;
+	return writer.buffer;
+}
+
+/**
+ * Function to write the students of a top list in sort order.
+ */
+static bool writeTop(FILE *output, TopList_t *top, const char *encoding, ss_Result_t *result) {
+	// Taking the last student off the heap each time fills the array from the back
+	size_t count = top->count;
+	ss_ListNode_t *nodes = (ss_ListNode_t *) allocate(sizeof(ss_ListNode_t) * (count + 1));
+	if (nodes == NULL) {
+		fclose(output);
+		return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+	}
+	for (size_t i = count; i > 0; i--) {
+		nodes[i - 1].student = &top->entries[top->heap[0]].student;
+		nodes[i - 1].next = (i < count) ? &nodes[i] : NULL;
+		top->heap[0] = top->heap[--top->count];
+		siftTopDown(top, 0);
+	}
+
+	bool written = ss_writeFile(output, (count > 0) ? &nodes[0] : NULL, encoding, result);
+	free(nodes);
+	return written;
+}
+
+/**
+ * Function to pick the list to sort for the option.
+ */
+ss_ListNode_t *ss_selectList(ss_StudentList_t *list, const int option) {
+	switch (option) {
+		case 1: return list->head_d; // Domestic
+		case 2: return list->head_i; // International
+		case 3: return list->head_a; // All
+	}
+	return NULL;
+}
+
+/**
+ * Function to set options to their defaults.
+ */
+void ss_initOptions(ss_Options_t *options) {
+	options->input_name = NULL;
+	options->output_name = NULL;
+	options->option = 3;
+	options->sort_mode = SS_SORT_MERGE;
+	options->threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	if (options->threads < 1) options->threads = 1;
+	options->memory = 0;
+	options->top = 0;
+	options->stats = NULL;
+	options->snapshot_name = NULL;
+	options->cache_name = NULL;
+	options->cache_size = (size_t) 1024 * 1024 * 1024;
+	options->key = NULL;
+}
+
+/**
+ * Function to sort a list with the sort mode from the options.
+ */
+void ss_sortStudents(ss_ListNode_t **head, const ss_Options_t *options) {
+	if (options->key != NULL && options->key->custom) {
+		keyedSortList(head, options->key);
+		return;
+	}
+	switch (options->sort_mode) {
+		case SS_SORT_MERGE: tableSortList(head); break;
+		case SS_SORT_RADIX: radixSortList(head); break;
+		case SS_SORT_NATURAL: naturalSortList(head); break;
+		case SS_SORT_PARALLEL: parallelSortList(head, options->threads); break;
+	}
+}
+
+/**
+ * Function to split a sorted list into domestic and international lists.
+ * Stable, so both lists stay sorted. Students with no status are dropped.
+ * Reuses the nodes, so the list itself is gone afterwards.
+ */
+static void partitionList(ss_ListNode_t *head, ss_ListNode_t **domestic, ss_ListNode_t **international) {
+	ss_ListNode_t *tails[2] = {NULL, NULL};
+	*domestic = NULL;
+	*international = NULL;
+
+	while (head != NULL) {
+		ss_ListNode_t *node = head;
+		head = head->next;
+		node->next = NULL;
+
+		switch (node->student->status_value) {
+			case SS_STATUS_DOMESTIC:
+				if (tails[0] == NULL) *domestic = node;
+				else tails[0]->next = node;
+				tails[0] = node;
+				break;
+			case SS_STATUS_INTERNATIONAL:
+				if (tails[1] == NULL) *international = node;
+				else tails[1]->next = node;
+				tails[1] = node;
+				break;
+		}
+	}
+}
+
+/**
+ * Function to write a list to the output file of one option.
+ * Option 4 writes each list to <output_file>.<option>.
+ */
+static bool writeView(const char *output_name, int option, ss_ListNode_t *head, const char *encoding, ss_Result_t *result) {
+	size_t length = strlen(output_name) + 3;
+	char *name = (char *) allocate(length);
+	if (name == NULL) return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+	snprintf(name, length, "%s.%d", output_name, option);
+
+	FILE *file = fopen(name, "w");
+	free(name);
+	if (file == NULL) return setError(result, SS_RESULT_IO, "Error: Output file could not open.");
+	return ss_writeFile(file, head, encoding, result);
+}
+
+/**
+ * Function to get the time in seconds from a steady clock.
+ * Always 0 unless stats are collected, so phases are not timed for nothing.
+ */
+static double now() {
+	if (!collect_stats) return 0.0;
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
+
+/**
+ * Function to sort all students once and write all three lists.
+ * The domestic and international lists come from a stable partition of the
+ * sorted list, so they match what options 1 and 2 write. Skips the sort if
+ * the list was loaded already sorted.
+ */
+static bool sortAllViews(ss_StudentList_t *list, const ss_Options_t *options, const char *encoding, bool sorted, ss_Stats_t *stats,
+	ss_Result_t *result) {
+	double start = now();
+	ss_ListNode_t *head = list->head_a;
+	if (!sorted) ss_sortStudents(&head, options);
+	stats->sort_seconds += now() - start;
+
+	start = now();
+	bool written = writeView(options->output_name, 3, head, encoding, result);
+	if (written) {
+		ss_ListNode_t *domestic;
+		ss_ListNode_t *international;
+		partitionList(head, &domestic, &international);
+		written = writeView(options->output_name, 1, domestic, encoding, result) &&
+			writeView(options->output_name, 2, international, encoding, result);
+	}
+	stats->write_seconds += now() - start;
+	return written;
+}
+
+/**
+ * Function to create a temporary file.
+ * Made in $TMPDIR, or /tmp, and removed as soon as it is closed.
+ * Returns NULL with the error in result if it could not be created.
+ */
+static FILE *createTempFile(ss_Result_t *result) {
+	const char *directory = getenv("TMPDIR");
+	if (directory == NULL || *directory == '\0') directory = "/tmp";
+
+	size_t length = strlen(directory) + sizeof("/a2_run_XXXXXX");
+	char *path = (char *) allocate(length);
+	if (path == NULL) {
+		setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+		return NULL;
+	}
+	snprintf(path, length, "%s/a2_run_XXXXXX", directory);
+
+	int fd = mkstemp(path);
+	if (fd >= 0) unlink(path);
+	free(path);
+
+	FILE *file = (fd >= 0) ? fdopen(fd, "w+b") : NULL;
+	if (file == NULL) {
+		if (fd >= 0) close(fd);
+		setError(result, SS_RESULT_IO, "Error: Could not create temporary file.");
+	}
+	return file;
+}
+
+/**
+ * Function to spill a sorted list to a temporary run file.
+ * Returns the file rewound for reading, or NULL with the error in result.
+ */
+static FILE *spillList(ss_ListNode_t *head, ss_Result_t *result) {
+	FILE *file = createTempFile(result);
+	if (file == NULL) return NULL;
+
+	for (ss_ListNode_t *current = head; current != NULL; current = current->next) {
+		ss_Student_t *student = current->student;
+		ss_Slice_t *fields[] = {
+			&student->first_name, &student->last_name, &student->birth_month, &student->birth_day,
+			&student->birth_year, &student->gpa, &student->status, &student->toefl
+		};
+
+		SpillHeader_t header;
+		memset(&header, 0, sizeof(header));
+		for (int i = 0; i < 8; i++) header.lengths[i] = (fields[i]->text != NULL) ? fields[i]->length : SPILL_MISSING;
+		header.year_value = student->year_value;
+		header.gpa_value = student->gpa_value;
+		header.month_index = student->month_index;
+		header.day_value = student->day_value;
+		header.toefl_value = student->toefl_value;
+		header.status_value = student->status_value;
+
+		fwrite(&header, sizeof(header), 1, file);
+		for (int i = 0; i < 8; i++)
+			if (fields[i]->text != NULL) fwrite(fields[i]->text, 1, fields[i]->length, file);
+	}
+
+	if (ferror(file) || fflush(file) != 0) {
+		fclose(file);
+		setError(result, SS_RESULT_IO, "Error: Could not write temporary file.");
+		return NULL;
+	}
+	rewind(file);
+	return file;
+}
+
+/**
+ * Function to read the next student of a run file.
+ * The fields point into the text buffer of the run until the next call.
+ * Clears found at the end of the run. Returns false if the run cannot be read.
+ */
+static bool nextSpilled(SpillFile_t *spill, bool *found, ss_Result_t *result) {
+	SpillHeader_t header;
+	*found = false;
+	if (fread(&header, sizeof(header), 1, spill->file) != 1) {
+		if (ferror(spill->file)) return setError(result, SS_RESULT_IO, "Error: Could not read temporary file.");
+		return true;
+	}
+
+	size_t total = 0;
+	for (int i = 0; i < 8; i++)
+		if (header.lengths[i] != SPILL_MISSING) total += header.lengths[i];
+
+	if (total > spill->text_size) {
+		char *temp = (char *) reallocate(spill->text, total);
+		if (temp == NULL) return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+		spill->text = temp;
+		spill->text_size = total;
+	}
+	if (total > 0 && fread(spill->text, 1, total, spill->file) != total)
+		return setError(result, SS_RESULT_IO, "Error: Could not read temporary file.");
+
+	ss_Student_t *student = &spill->student;
+	ss_Slice_t *fields[] = {
+		&student->first_name, &student->last_name, &student->birth_month, &student->birth_day,
+		&student->birth_year, &student->gpa, &student->status, &student->toefl
+	};
+	size_t offset = 0;
+	for (int i = 0; i < 8; i++) {
+		if (header.lengths[i] == SPILL_MISSING) {
+			*fields[i] = makeSlice(NULL, 0);
+		} else {
+			*fields[i] = makeSlice(spill->text + offset, header.lengths[i]);
+			offset += header.lengths[i];
+		}
+	}
+	student->year_value = header.year_value;
+	student->gpa_value = header.gpa_value;
+	student->month_index = header.month_index;
+	student->day_value = header.day_value;
+	student->toefl_value = header.toefl_value;
+	student->status_value = header.status_value;
+	student->last_rank = SS_RANK_NONE; // Runs are merged by text
+	student->first_rank = SS_RANK_NONE;
+
+	*found = true;
+	return true;
+}
+
+/**
+ * Function to check if the student of run a goes before that of run b.
+ * Ties go to the earlier run, which keeps the merge stable.
+ */
+static bool spillBefore(SpillFile_t *spills, int a, int b) {
+	int result = ss_compareStudents(&spills[a].student, &spills[b].student);
+	return result < 0 || (result == 0 && a < b);
+}
+
+/**
+ * Function to move a run down the merge heap to its place.
+ */
+static void siftDown(SpillFile_t *spills, int *heap, int heap_count, int index) {
+	while (true) {
+		int smallest = index;
+		int left = index * 2 + 1;
+		int right = left + 1;
+		if (left < heap_count && spillBefore(spills, heap[left], heap[smallest])) smallest = left;
+		if (right < heap_count && spillBefore(spills, heap[right], heap[smallest])) smallest = right;
+		if (smallest == index) return;
+
+		int swap = heap[index];
+		heap[index] = heap[smallest];
+		heap[smallest] = swap;
+		index = smallest;
+	}
+}
+
+/**
+ * Function to close and free the run files of an external sort.
+ */
+static void freeSpills(SpillFile_t *spills, int spill_count) {
+	for (int i = 0; i < spill_count; i++) {
+		fclose(spills[i].file);
+		free(spills[i].text);
+	}
+	free(spills);
+}
+
+/**
+ * Function to sort an input that may not fit in memory.
+ *
+ * Reads chunks of about options->memory bytes of students, sorts each chunk
+ * with the chosen sort and spills it to a temporary run file. The runs are
+ * then merged with a heap straight into the output file. Chunks are in input
+ * order and ties take the earlier run, so the output is the same as sorting
+ * in memory. If the whole input fits in one chunk nothing is spilled.
+ */
+static bool externalSort(Input_t *input, ss_StudentList_t *list, const ss_Options_t *options, char *encoding,
+	ss_Stats_t *stats, ss_Result_t *result) {
+	SpillFile_t *spills = NULL;
+	int spill_count = 0;
+	int spill_size = 0;
+	bool more = true;
+
+	while (more) {
+		double start = now();
+		bool read = readFile(input, list, options->option, encoding, options->memory, &more, result);
+		stats->read_seconds += now() - start;
+		if (!read) {
+			freeSpills(spills, spill_count);
+			return false;
+		}
+
+		start = now();
+		ss_ListNode_t *head = ss_selectList(list, options->option);
+		ss_sortStudents(&head, options);
+		stats->sort_seconds += now() - start;
+		start = now();
+
+		// Everything fit, so write it directly
+		if (!more && spill_count == 0) {
+			FILE *output = fopen(options->output_name, "w");
+			if (output == NULL) return setError(result, SS_RESULT_IO, "Error: Output file could not open.");
+			bool written = ss_writeFile(output, head, encoding, result);
+			ss_freeList(list);
+			stats->write_seconds += now() - start;
+			return written;
+		}
+
+		if (spill_count == spill_size) {
+			spill_size = (spill_size != 0) ? spill_size * 2 : 16;
+			SpillFile_t *temp = (SpillFile_t *) reallocate(spills, sizeof(SpillFile_t) * spill_size);
+			if (temp == NULL) {
+				freeSpills(spills, spill_count);
+				return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+			}
+			spills = temp;
+		}
+		spills[spill_count].file = spillList(head, result);
+		if (spills[spill_count].file == NULL) {
+			freeSpills(spills, spill_count);
+			return false;
+		}
+		spills[spill_count].text = NULL;
+		spills[spill_count].text_size = 0;
+		spill_count++;
+		ss_freeList(list);
+		stats->write_seconds += now() - start;
+	}
+
+	// Fill the heap with the first student of every run
+	double start = now();
+	int *heap = (int *) allocate(sizeof(int) * spill_count);
+	if (heap == NULL) {
+		freeSpills(spills, spill_count);
+		return setError(result, SS_RESULT_NO_MEMORY, "Error: Memory could not be allocated.");
+	}
+	int heap_count = 0;
+	bool found;
+	bool merged = true;
+	for (int i = 0; i < spill_count && merged; i++) {
+		merged = nextSpilled(&spills[i], &found, result);
+		if (merged && found) heap[heap_count++] = i;
+	}
+	for (int i = heap_count / 2 - 1; i >= 0; i--) siftDown(spills, heap, heap_count, i);
+
+	FILE *output = NULL;
+	if (merged) {
+		output = fopen(options->output_name, "w");
+		if (output == NULL) merged = setError(result, SS_RESULT_IO, "Error: Output file could not open.");
+	}
+	Writer_t writer;
+	if (merged && !initWriter(&writer, output, result)) {
+		fclose(output);
+		output = NULL;
+		merged = false;
+	}
+
+	if (output != NULL) {
+		// Write the smallest student, then replace it with the next of its run
+		while (heap_count > 0 && merged) {
+			SpillFile_t *top = &spills[heap[0]];
+			merged = writeStudent(&writer, &top->student, encoding, result) && nextSpilled(top, &found, result);
+			if (!found) heap[0] = heap[--heap_count];
+			siftDown(spills, heap, heap_count, 0);
+		}
+		if (merged) merged = freeWriter(&writer, result);
+		else free(writer.buffer);
+
+		// Close the output file
+		fclose(output);
+	}
+
+	freeSpills(spills, spill_count);
+	free(heap);
+	stats->write_seconds += now() - start;
+	return merged;
+}
+
+/**
+ * Function to checksum the body of a snapshot, 8 bytes at a time.
+ */
+static uint64_t checksumSnapshot(const unsigned char *data, size_t length) {
+	uint64_t hash = 14695981039346656037ULL;
+	size_t i = 0;
+	for (; i + 8 <= length; i += 8) {
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * 1099511628211ULL;
+		hash ^= hash >> 29;
+	}
+	for (; i < length; i++) hash = (hash ^ data[i]) * 1099511628211ULL;
+	return hash;
+}
+
+/**
+ * Function to find where each column of a snapshot starts.
+ * Every column is 8 byte aligned.
+ */
+static void layoutSnapshot(uint64_t count, uint64_t text_length, SnapshotLayout_t *layout) {
+	size_t offset = sizeof(SnapshotHeader_t);
+	size_t *columns[] = {
+		&layout->years, &layout->gpas, &layout->months, &layout->days, &layout->toefls, &layout->statuses,
+		&layout->last_ranks, &layout->first_ranks, &layout->offsets, &layout->lengths, &layout->text
+	};
+	size_t widths[] = {
+		sizeof(uint16_t) * count, sizeof(uint16_t) * count, count, count, count, count,
+		sizeof(uint32_t) * count, sizeof(uint32_t) * count, sizeof(uint64_t) * count, sizeof(uint32_t) * 8 * count, text_length
+	};
+	for (int i = 0; i < 11; i++) {
+		*columns[i] = offset;
+		offset = (offset + widths[i] + 7) & ~(size_t) 7;
+	}
+	layout->size = offset;
+}
+
+/**
+ * Function to fill in the header fields that tie a snapshot to its input file.
+ */
+static void stampSnapshot(SnapshotHeader_t *header, const struct stat *info) {
+	memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+	header->version = SNAPSHOT_VERSION;
+	header->header_size = sizeof(SnapshotHeader_t);
+	header->input_size = (uint64_t) info->st_size;
+	header->input_seconds = (int64_t) info->st_mtim.tv_sec;
+	header->input_nanoseconds = (int64_t) info->st_mtim.tv_nsec;
+	header->input_inode = (uint64_t) info->st_ino;
+	header->input_device = (uint64_t) info->st_dev;
+}
+
+/**
+ * Function to save the students of a list to a snapshot file.
+ * The all list must be sorted. Written to a temporary name and renamed,
+ * so a reader never sees half a snapshot. Returns false if it could not be
+ * written, which only costs the next run a parse.
+ */
+static bool saveSnapshot(const char *name, Input_t *input, ss_StudentList_t *list, char encoding) {
+	struct stat info;
+	if (fstat(fileno(input->file), &info) != 0 || !S_ISREG(info.st_mode)) return false;
+
+	uint64_t count = 0;
+	uint64_t text_length = 0;
+	for (ss_ListNode_t *current = list->head_a; current != NULL; current = current->next, count++)
+		text_length += studentTextLength(current->student);
+	SnapshotLayout_t layout;
+	layoutSnapshot(count, text_length, &layout);
+
+	size_t temp_length = strlen(name) + 24;
+	char *temp_name = (char *) allocate(temp_length);
+	if (temp_name == NULL) return false;
+	snprintf(temp_name, temp_length, "%s.%ld.tmp", name, (long) getpid());
+	int fd = open(temp_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	unsigned char *data = MAP_FAILED;
+	if (fd >= 0 && ftruncate(fd, (off_t) layout.size) == 0)
+		data = (unsigned char *) mmap(NULL, layout.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		if (fd >= 0) close(fd);
+		unlink(temp_name);
+		free(temp_name);
+		return false;
+	}
+
+	uint16_t *years = (uint16_t *) (data + layout.years);
+	uint16_t *gpas = (uint16_t *) (data + layout.gpas);
+	uint32_t *last_ranks = (uint32_t *) (data + layout.last_ranks);
+	uint32_t *first_ranks = (uint32_t *) (data + layout.first_ranks);
+	uint64_t *offsets = (uint64_t *) (data + layout.offsets);
+	uint32_t *lengths = (uint32_t *) (data + layout.lengths);
+	char *text = (char *) (data + layout.text);
+	uint64_t offset = 0;
+	size_t i = 0;
+	for (ss_ListNode_t *current = list->head_a; current != NULL; current = current->next, i++) {
+		ss_Student_t *student = current->student;
+		years[i] = student->year_value;
+		gpas[i] = student->gpa_value;
+		data[layout.months + i] = student->month_index;
+		data[layout.days + i] = student->day_value;
+		data[layout.toefls + i] = student->toefl_value;
+		data[layout.statuses + i] = student->status_value;
+		last_ranks[i] = student->last_rank;
+		first_ranks[i] = student->first_rank;
+		offsets[i] = offset;
+
+		// Fields of a student are stored one after another from its offset
+		ss_Slice_t *fields[] = {
+			&student->first_name, &student->last_name, &student->birth_month, &student->birth_day,
+			&student->birth_year, &student->gpa, &student->status, &student->toefl
+		};
+		for (int field = 0; field < 8; field++) {
+			lengths[i * 8 + field] = (fields[field]->text != NULL) ? fields[field]->length : SPILL_MISSING;
+			if (fields[field]->text == NULL) continue;
+			memcpy(text + offset, fields[field]->text, fields[field]->length);
+			offset += fields[field]->length;
+		}
+	}
+
+	SnapshotHeader_t header;
+	memset(&header, 0, sizeof(header));
+	stampSnapshot(&header, &info);
+	header.count = count;
+	header.text_length = text_length;
+	header.encoding = encoding;
+	header.sorted = 1;
+	header.checksum = checksumSnapshot(data + sizeof(header), layout.size - sizeof(header));
+	memcpy(data, &header, sizeof(header));
+
+	bool saved = munmap(data, layout.size) == 0;
+	saved = close(fd) == 0 && saved;
+	saved = saved && rename(temp_name, name) == 0;
+	if (!saved) unlink(temp_name);
+	free(temp_name);
+	return saved;
+}
+
+/**
+ * Function to load the students of a snapshot file into a list instead of
+ * reading the input file. The snapshot is mapped as the input data, so the
+ * students point into it until closeInput.
+ * Returns false, leaving the list empty, if there is no snapshot or it was
+ * made from another version of the input or of this format, or fails its checksum.
+ */
+static bool loadSnapshot(const char *name, Input_t *input, ss_StudentList_t *list, char *encoding, bool *sorted) {
+	struct stat info;
+	struct stat snapshot_info;
+	if (fstat(fileno(input->file), &info) != 0 || !S_ISREG(info.st_mode)) return false;
+	int fd = open(name, O_RDONLY);
+	if (fd < 0) return false;
+	if (fstat(fd, &snapshot_info) != 0 || snapshot_info.st_size < (off_t) sizeof(SnapshotHeader_t)) {
+		close(fd);
+		return false;
+	}
+	size_t size = (size_t) snapshot_info.st_size;
+	unsigned char *data = (unsigned char *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) return false;
+
+	// Check the header before anything it points to
+	SnapshotHeader_t header;
+	SnapshotHeader_t expected;
+	memcpy(&header, data, sizeof(header));
+	memset(&expected, 0, sizeof(expected));
+	stampSnapshot(&expected, &info);
+	SnapshotLayout_t layout;
+	bool valid = memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 && header.version == expected.version
+		&& header.header_size == expected.header_size && header.input_size == expected.input_size
+		&& header.input_seconds == expected.input_seconds && header.input_nanoseconds == expected.input_nanoseconds
+		&& header.input_inode == expected.input_inode && header.input_device == expected.input_device
+		&& header.count <= size && header.text_length <= size;
+	if (valid) {
+		layoutSnapshot(header.count, header.text_length, &layout);
+		valid = layout.size == size && checksumSnapshot(data + sizeof(header), size - sizeof(header)) == header.checksum;
+	}
+	if (!valid) {
+		munmap(data, size);
+		return false;
+	}
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	const uint16_t *years = (const uint16_t *) (data + layout.years);
+	const uint16_t *gpas = (const uint16_t *) (data + layout.gpas);
+	const uint32_t *last_ranks = (const uint32_t *) (data + layout.last_ranks);
+	const uint32_t *first_ranks = (const uint32_t *) (data + layout.first_ranks);
+	const uint64_t *offsets = (const uint64_t *) (data + layout.offsets);
+	const uint32_t *lengths = (const uint32_t *) (data + layout.lengths);
+	const char *text = (const char *) (data + layout.text);
+	ss_Result_t ignored;
+	uint32_t rank_set = nextRankSet(); // Ranks of one snapshot come from one table
+	for (size_t i = 0; i < header.count && valid; i++) {
+		ss_Student_t *student = createNode(list);
+		valid = student != NULL && data[layout.statuses + i] <= SS_STATUS_NONE;
+		if (!valid) break;
+		student->year_value = years[i];
+		student->gpa_value = gpas[i];
+		student->month_index = data[layout.months + i];
+		student->day_value = data[layout.days + i];
+		student->toefl_value = data[layout.toefls + i];
+		student->status_value = data[layout.statuses + i];
+		student->last_rank = last_ranks[i];
+		student->first_rank = first_ranks[i];
+		student->rank_set = rank_set;
+
+		ss_Slice_t *fields[] = {
+			&student->first_name, &student->last_name, &student->birth_month, &student->birth_day,
+			&student->birth_year, &student->gpa, &student->status, &student->toefl
+		};
+		uint64_t offset = offsets[i];
+		for (int field = 0; field < 8 && valid; field++) {
+			uint32_t length = lengths[i * 8 + field];
+			if (length == SPILL_MISSING) continue;
+			valid = offset <= header.text_length && length <= header.text_length - offset;
+			if (valid) *fields[field] = makeSlice(text + offset, length);
+			offset += length;
+		}
+
+		list->count_a++;
+		if (student->status_value == SS_STATUS_DOMESTIC) list->count_d++;
+		else if (student->status_value == SS_STATUS_INTERNATIONAL) list->count_i++;
+		valid = valid && appendList(list, student, &ignored);
+	}
+	if (!valid) {
+		ss_clearList(list);
+		munmap(data, size);
+		return false;
+	}
+
+	input->data = (const char *) data;
+	input->length = size;
+	input->position = size;
+	*encoding = header.encoding;
+	*sorted = header.sorted != 0;
+	return true;
+}
+
+/**
+ * Function to make the cache key of an input file, a hash of its bytes and of
+ * everything else that changes the output: option, top count and sort key.
+ * Two 64 bit lanes are hashed 8 bytes at a time and written as 32 hex digits.
+ * Returns false if the input is not a regular file that can be mapped.
+ */
+static bool cacheKey(FILE *file, const ss_Options_t *options, char *key, size_t *length) {
+	struct stat info;
+	int fd = fileno(file);
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) return false;
+	*length = (size_t) info.st_size;
+
+	const unsigned char *data = NULL;
+	if (*length > 0) {
+		void *mapped = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) return false;
+		madvise(mapped, *length, MADV_SEQUENTIAL);
+		data = (const unsigned char *) mapped;
+	}
+
+	uint64_t high = 14695981039346656037ULL;
+	uint64_t low = 0x9E3779B97F4A7C15ULL;
+	size_t i = 0;
+	for (; i + 8 <= *length; i += 8) {
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		high = (high ^ word) * 1099511628211ULL;
+		high ^= high >> 29;
+		low = (low + word) * 0xFF51AFD7ED558CCDULL;
+		low ^= low >> 32;
+	}
+	uint64_t tail = 0;
+	if (data != NULL) memcpy(&tail, data + i, *length - i);
+	uint64_t order = 0; // Fields and directions of a custom key, 0 for the default order
+	for (int j = 0; j < SS_SORT_FIELDS && options->key != NULL && options->key->custom; j++)
+		order = order << 4 | (uint64_t) options->key->fields[j] << 1 | options->key->descending[j];
+	uint64_t extra[] = {tail, *length, (uint64_t) options->option, options->top, order, CACHE_VERSION};
+	for (int j = 0; j < 6; j++) {
+		high = (high ^ extra[j]) * 1099511628211ULL;
+		high ^= high >> 29;
+		low = (low + extra[j]) * 0xFF51AFD7ED558CCDULL;
+		low ^= low >> 32;
+	}
+	if (data != NULL) munmap((void *) data, *length);
+
+	snprintf(key, CACHE_KEY_SIZE, "%016llx%016llx", (unsigned long long) high, (unsigned long long) low);
+	return true;
+}
+
+/**
+ * Function to join the cache directory and a file name.
+ * Returns NULL if memory could not be allocated.
+ */
+static char *cachePath(const char *directory, const char *name) {
+	size_t length = strlen(directory) + strlen(name) + 2;
+	char *path = (char *) allocate(length);
+	if (path != NULL) snprintf(path, length, "%s/%s", directory, name);
+	return path;
+}
+
+/**
+ * Function to copy one file to another, as a reflink if the file system
+ * can share the blocks, else byte by byte.
+ * Returns the bytes copied, or -1 if the copy failed.
+ */
+static ssize_t copyFile(const char *from_name, const char *to_name) {
+	int from = open(from_name, O_RDONLY);
+	if (from < 0) return -1;
+	int to = open(to_name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (to < 0) {
+		close(from);
+		return -1;
+	}
+
+	ssize_t total = -1;
+#ifdef FICLONE
+	struct stat info;
+	if (fstat(from, &info) == 0 && ioctl(to, FICLONE, from) == 0) total = (ssize_t) info.st_size;
+#endif
+	if (total < 0) {
+		char buffer[64 * 1024];
+		ssize_t count;
+		total = 0;
+		while ((count = read(from, buffer, sizeof(buffer))) > 0) {
+			if (write(to, buffer, (size_t) count) != count) {
+				total = -1;
+				break;
+			}
+			total += count;
+		}
+		if (count < 0) total = -1;
+	}
+	close(from);
+	if (close(to) != 0) total = -1;
+	return total;
+}
+
+/**
+ * Function to write the output of an earlier run from the cache.
+ * Marks the entry as just used, so it is evicted last.
+ * Returns false if there is no entry or it could not be copied.
+ */
+static bool copyFromCache(const ss_Options_t *options, const char *key) {
+	char *path = cachePath(options->cache_name, key);
+	if (path == NULL) return false;
+	ssize_t copied = copyFile(path, options->output_name);
+	if (copied >= 0) {
+		utimensat(AT_FDCWD, path, NULL, 0);
+		counters.bytes_written += (uint64_t) copied;
+	}
+	free(path);
+	return copied >= 0;
+}
+
+/**
+ * Function to order cache entries from least to most recently used.
+ */
+static int compareCacheEntries(const void *a, const void *b) {
+	const CacheEntry_t *left = (const CacheEntry_t *) a;
+	const CacheEntry_t *right = (const CacheEntry_t *) b;
+	if (left->used_seconds != right->used_seconds) return (left->used_seconds < right->used_seconds) ? -1 : 1;
+	return (left->used_nanoseconds > right->used_nanoseconds) - (left->used_nanoseconds < right->used_nanoseconds);
+}
+
+/**
+ * Function to remove the least recently used cache entries until the cache
+ * holds at most options->cache_size bytes. Only files named like a key are counted.
+ */
+static void evictCache(const ss_Options_t *options) {
+	DIR *directory = opendir(options->cache_name);
+	if (directory == NULL) return;
+
+	CacheEntry_t *entries = NULL;
+	size_t count = 0;
+	size_t capacity = 0;
+	uint64_t total = 0;
+	struct dirent *item;
+	while ((item = readdir(directory)) != NULL) {
+		if (strlen(item->d_name) != CACHE_KEY_SIZE - 1 || strspn(item->d_name, "0123456789abcdef") != CACHE_KEY_SIZE - 1)
+			continue;
+		struct stat info;
+		if (fstatat(dirfd(directory), item->d_name, &info, 0) != 0 || !S_ISREG(info.st_mode)) continue;
+		if (count == capacity) {
+			capacity = (capacity == 0) ? 64 : capacity * 2;
+			CacheEntry_t *temp = (CacheEntry_t *) reallocate(entries, sizeof(CacheEntry_t) * capacity);
+			if (temp == NULL) break;
+			entries = temp;
+		}
+		CacheEntry_t *entry = &entries[count++];
+		memcpy(entry->key, item->d_name, CACHE_KEY_SIZE);
+		entry->size = (uint64_t) info.st_size;
+		entry->used_seconds = (int64_t) info.st_mtim.tv_sec;
+		entry->used_nanoseconds = (int64_t) info.st_mtim.tv_nsec;
+		total += entry->size;
+	}
+
+	if (total > options->cache_size) {
+		qsort(entries, count, sizeof(CacheEntry_t), compareCacheEntries);
+		for (size_t i = 0; i < count && total > options->cache_size; i++)
+			if (unlinkat(dirfd(directory), entries[i].key, 0) == 0) total -= entries[i].size;
+	}
+	free(entries);
+	closedir(directory);
+}
+
+/**
+ * Function to add the output of this run to the cache, then evict.
+ * Copied to a temporary name and renamed, so other runs never see half an entry.
+ * Failing only costs the next run its sort.
+ */
+static void saveToCache(const ss_Options_t *options, const char *key) {
+	char temp_name[CACHE_KEY_SIZE + 32];
+	snprintf(temp_name, sizeof(temp_name), "%s.%ld.%lu.tmp", key, (long) getpid(), (unsigned long) pthread_self());
+	char *path = cachePath(options->cache_name, key);
+	char *temp_path = cachePath(options->cache_name, temp_name);
+	if (path != NULL && temp_path != NULL) {
+		mkdir(options->cache_name, 0777);
+		if (copyFile(options->output_name, temp_path) < 0 || rename(temp_path, path) != 0) unlink(temp_path);
+		else evictCache(options);
+	}
+	free(path);
+	free(temp_path);
+}
+
+/**
+ * Function to read, sort and write an open input file.
+ * Returns false with the error in result.
+ */
+static bool sortInput(const ss_Options_t *options, ss_StudentList_t *list, Input_t *input, ss_Stats_t *stats, ss_Result_t *result) {
+	const char *output_name = options->output_name;
+	const int option = options->option;
+	FILE *file;
+
+	// Read from input file, mapped into memory if it is a regular file. An up to
+	// date snapshot is mapped instead, when there is no top count or memory budget.
+	char encoding = 'U'; // Default encoding is UNIX. Function changes to Windows if needed.
+	bool more;
+	bool snapshot = options->snapshot_name != NULL && options->top == 0 && options->memory == 0;
+	bool sorted = false;
+	double start = now();
+	bool loaded = snapshot && loadSnapshot(options->snapshot_name, input, list, &encoding, &sorted);
+	if (!loaded) mapInput(input);
+	stats->read_seconds += now() - start;
+
+	if (options->top != 0) {
+		// With a top count, keep only the first students while reading
+		TopList_t top;
+		start = now();
+		initTopList(&top, options->top, option);
+		list->top = &top;
+		bool written = readFile(input, list, option, &encoding, 0, &more, result);
+		list->top = NULL;
+		stats->read_seconds += now() - start;
+
+		start = now();
+		if (written) {
+			file = fopen(output_name, "w");
+			if (file == NULL) written = setError(result, SS_RESULT_IO, "Error: Output file could not open.");
+			else written = writeTop(file, &top, &encoding, result);
+		}
+		freeTopList(&top);
+		stats->write_seconds += now() - start;
+		return written;
+	}
+	if (options->memory != 0) {
+		// With a memory budget, sort in chunks through temporary files
+		return externalSort(input, list, options, &encoding, stats, result);
+	}
+
+	start = now();
+	bool read = loaded || readInput(input, list, option, &encoding, options->threads, result);
+	stats->read_seconds += now() - start;
+	if (!read) return false;
+
+	if (snapshot && !loaded) {
+		// Sort every student once and save them in that order for the next run
+		ss_Options_t default_order = *options;
+		default_order.key = NULL;
+		start = now();
+		ss_sortStudents(&list->head_a, &default_order);
+		stats->sort_seconds += now() - start;
+		start = now();
+		saveSnapshot(options->snapshot_name, input, list, encoding);
+		stats->write_seconds += now() - start;
+		if (option == 1 || option == 2) partitionList(list->head_a, &list->head_d, &list->head_i);
+		sorted = true;
+	}
+	if (options->key != NULL && options->key->custom) sorted = false; // Snapshots are in the default order
+	if (option == 4) return sortAllViews(list, options, &encoding, sorted, stats, result);
+
+	start = now();
+	ss_ListNode_t *head = ss_selectList(list, option);
+	if (!sorted) ss_sortStudents(&head, options);
+	stats->sort_seconds += now() - start;
+
+	// Write to output file
+	start = now();
+	file = fopen(output_name, "w");
+	if (file == NULL) {
+		return setError(result, SS_RESULT_IO, "Error: Output file could not open.");
+	}
+	bool written = ss_writeFile(file, head, &encoding, result);
+	stats->write_seconds += now() - start;
+	return written;
+}
+
+/**
+ * Function to read, sort and write one input file.
+ * With a cache, the output of an earlier run of the same input is copied
+ * instead, and the output of this run is saved for the next one.
+ * Returns false with the error in result, leaving input open for ss_sortFile to close.
+ */
+static bool processFile(const ss_Options_t *options, ss_StudentList_t *list, Input_t *input, ss_Stats_t *stats, ss_Result_t *result) {
+	// Open input file
+	FILE *file = fopen(options->input_name, "r");
+	if (file == NULL) return setError(result, SS_RESULT_IO, "Error: Input file not found.");
+	fseek(file, 0, SEEK_SET); // Ensure cursor at start of file
+	input->file = file;
+
+	// Check if option is valid
+	const int option = options->option;
+	if (option < 1 || option > 4) return setError(result, SS_RESULT_INVALID_ARGUMENT, "Error: Invalid option.");
+	if (option == 4 && (options->top != 0 || options->memory != 0))
+		return setError(result, SS_RESULT_INVALID_ARGUMENT, "Error: Option 4 cannot be used with --top or --memory.");
+	if (options->key != NULL && options->key->custom && (options->top != 0 || options->memory != 0))
+		return setError(result, SS_RESULT_INVALID_ARGUMENT, "Error: --key cannot be used with --top or --memory.");
+	if (options->cache_name == NULL || option == 4) return sortInput(options, list, input, stats, result);
+
+	// Copy the output of an earlier run of the same input from the cache
+	char key[CACHE_KEY_SIZE];
+	size_t length;
+	double start = now();
+	bool cached = cacheKey(file, options, key, &length);
+	stats->read_seconds += now() - start;
+	if (cached) {
+		start = now();
+		bool copied = copyFromCache(options, key);
+		stats->write_seconds += now() - start;
+		if (copied) {
+			input->position = length;
+			return true;
+		}
+	}
+
+	bool done = sortInput(options, list, input, stats, result);
+	if (done && cached) {
+		start = now();
+		saveToCache(options, key);
+		stats->write_seconds += now() - start;
+	}
+	return done;
+}
+
+/**
+ * Function to read, sort and write one input file and clean up after it,
+ * whether it failed or not.
+ * The list is emptied afterwards but keeps its arena for the next file.
+ */
+bool ss_sortFile(const ss_Options_t *options, ss_StudentList_t *list, ss_Result_t *result) {
+	Input_t input = {NULL, NULL, 0, 0, 0, 0, NULL, 0};
+	ss_Stats_t stats;
+	memset(&stats, 0, sizeof(stats));
+	Counters_t before = counters;
+
+	bool done = processFile(options, list, &input, &stats, result);
+
+	if (options->stats != NULL) {
+		stats.records_d = list->count_d;
+		stats.records_i = list->count_i;
+		stats.records_a = list->count_a;
+		stats.compares = counters.compares - before.compares;
+		stats.allocations = counters.allocations - before.allocations;
+		stats.bytes_read = input.position;
+		stats.bytes_written = counters.bytes_written - before.bytes_written;
+		*options->stats = stats;
+	}
+
+	// Students may point into the mapped input, so close it only now
+	closeInput(&input);
+	ss_clearList(list);
+	return done;
+}
+
+/**
+ * Function to turn timing of phases and counting of compares and allocations on or off.
+ */
+void ss_collectStats(bool enabled) {
+	collect_stats = enabled;
+}
@@ -0,0 +1,327 @@
+#ifndef STUDENTSORT_H
+#define STUDENTSORT_H
+
+# include <stdio.h>
+# include <stdint.h>
+# include <stddef.h>
+# include <stdbool.h>
+
+/**
+ * Library to read, sort and write rosters of students.
+ *
+ * A roster has one student per line:
+ * 		"<first> <last> <Mon>-<day>-<year> <gpa> <D|I> [toefl]"
+ *
+ * Typical use:
+ * 		ss_StudentList_t list = {0};
+ * 		ss_Options_t options;
+ * 		ss_Result_t result;
+ * 		char encoding;
+ * 		ss_initOptions(&options);
+ * 		if (!ss_parseBuffer(text, length, &list, &encoding, &result)) ... result.message ...
+ * 		ss_ListNode_t *head = ss_selectList(&list, 3);
+ * 		ss_sortStudents(&head, &options);
+ * 		char *out = ss_serializeList(head, &encoding, &out_length, &result);
+ * 		free(out);
+ * 		ss_clearList(&list); // Or ss_freeList once the list is no longer needed
+ *
+ * Nothing here exits or prints. Functions that can fail return false, or NULL,
+ * and fill in an ss_Result_t. Every name starts with ss_, or SS_ for macros and
+ * enum values, so the library does not clash with names of the program.
+ */
+
+// Create a struct for text that does not end in '\0'
+typedef struct ss_Slice {
+	const char *text; // NULL if the field is missing
+	uint32_t length;
+} ss_Slice_t;
+
+// Create a struct for the entity
+typedef struct ss_Student {
+	ss_Slice_t first_name; // Alphabet
+	ss_Slice_t last_name; // Alphabet
+	ss_Slice_t birth_month; // Ranges from Jan to Dec
+	ss_Slice_t birth_day; // Ranges from 1 to 31
+	ss_Slice_t birth_year; // Ranges from 1950 to 2010
+	ss_Slice_t gpa; // Ranges from 0.0 to 4.3
+	ss_Slice_t status; // Either Domestic (D) or International (I)
+	ss_Slice_t toefl; // Ranges from 0 to 120
+
+	// Validated values used for sorting. Text above is kept for output only.
+	uint16_t year_value; // SS_YEAR_NONE if missing
+	uint16_t gpa_value; // Ten-thousandths, SS_GPA_NONE if missing
+	uint8_t month_index; // Index into months, SS_MONTH_NONE if missing
+	uint8_t day_value; // SS_DAY_NONE if missing
+	uint8_t toefl_value; // SS_TOEFL_NONE if missing
+	uint8_t status_value; // SS_STATUS_NONE if missing
+
+	// Rank of each name among the names of its list, in strcmp order, so the
+	// table sorts compare names as integers. Set once the list is read,
+	// SS_RANK_NONE if not ranked. Ranks are only compared between students with
+	// the same rank_set, which is 0 for a student that was not ranked.
+	uint32_t last_rank;
+	uint32_t first_rank;
+	uint32_t rank_set;
+} ss_Student_t;
+
+// Sentinels for missing fields. Missing sorts last, except TOEFL which sorts first.
+#define SS_YEAR_NONE UINT16_MAX
+#define SS_GPA_NONE UINT16_MAX
+#define SS_MONTH_NONE 12
+#define SS_DAY_NONE UINT8_MAX
+#define SS_TOEFL_NONE UINT8_MAX
+#define SS_RANK_NONE UINT32_MAX
+
+// Status values in sort order
+#define SS_STATUS_DOMESTIC 0
+#define SS_STATUS_INTERNATIONAL 1
+#define SS_STATUS_NONE 2
+
+// Create a struct for a bump allocator. Everything is freed at once.
+typedef struct ss_Arena {
+	struct ss_ArenaBlock *block; // Block being filled
+	size_t next_size; // Size of the next block
+	size_t allocated; // Bytes taken from malloc for all blocks
+} ss_Arena_t;
+
+// Create a wrapper struct to preserve order in ss_StudentList_t
+typedef struct ss_ListNode {
+	ss_Student_t *student;
+	struct ss_ListNode *next;
+} ss_ListNode_t;
+
+// Create a struct that orders the each of the lists by status.
+// Start from all zeros, and empty it with ss_clearList or ss_freeList.
+typedef struct ss_StudentList {
+	ss_ListNode_t *head_d; // Head of domestic list
+	ss_ListNode_t *tail_d;
+	ss_ListNode_t *head_i; // Head of international list
+	ss_ListNode_t *tail_i;
+	ss_ListNode_t *head_a; // Head of all list
+	ss_ListNode_t *tail_a;
+	ss_Arena_t arena; // Holds every student, list node and copied field
+	struct ss_TopList *top; // When set, students are offered to it instead of kept
+	struct ss_NameTable *names; // Each distinct name once, with the ranks of the students
+	size_t count_d; // Domestic students read, kept or not, until ss_clearList
+	size_t count_i; // International students read
+	size_t count_a; // All students read
+} ss_StudentList_t;
+
+// Create a struct for students kept in sort order as they are added and
+// removed. Made by ss_createIndex and freed by ss_freeIndex.
+typedef struct ss_StudentIndex ss_StudentIndex_t;
+
+// Kinds of error in an ss_Result_t
+typedef enum ss_ResultCode {
+	SS_RESULT_OK, // No error
+	SS_RESULT_INVALID_INPUT, // Input file is not in the expected format
+	SS_RESULT_INVALID_ARGUMENT, // Argument or option is not valid
+	SS_RESULT_NO_MEMORY, // Memory could not be allocated
+	SS_RESULT_IO // File could not be opened, read or written
+} ss_ResultCode_t;
+
+// Create a struct for the outcome of reading, sorting or writing.
+// Functions that can fail return false and fill it in, so a caller that keeps
+// running can report the error and go on. The message is the text the
+// program prints before exiting.
+typedef struct ss_Result {
+	ss_ResultCode_t code;
+	const char *message; // NULL if there is no error
+	size_t line; // Line of the input the error is on, from 1, or 0 if not about the input
+	size_t column; // Character of that line, from 1
+} ss_Result_t;
+
+// Sort engines selectable from the command line
+typedef enum ss_SortMode {
+	SS_SORT_MERGE, // Merge sort of row numbers over a table of the sort fields
+	SS_SORT_RADIX, // LSD radix sort on packed keys
+	SS_SORT_NATURAL, // Merge sort of the runs already in the list
+	SS_SORT_PARALLEL // Merge sort across threads
+} ss_SortMode_t;
+
+// Fields a sort key can order by, in the default order of ss_compareStudents
+typedef enum ss_SortField {
+	SS_FIELD_YEAR,
+	SS_FIELD_MONTH,
+	SS_FIELD_DAY,
+	SS_FIELD_LAST_NAME,
+	SS_FIELD_FIRST_NAME,
+	SS_FIELD_GPA,
+	SS_FIELD_TOEFL,
+	SS_FIELD_STATUS
+} ss_SortField_t;
+
+#define SS_SORT_FIELDS 8
+
+// Create a struct for a sort order, made by ss_compileSortKey
+typedef struct ss_SortKey {
+	ss_SortField_t fields[SS_SORT_FIELDS]; // Most significant first, each field once
+	bool descending[SS_SORT_FIELDS]; // Whether each field of fields is reversed
+	bool custom; // False if this is the default order of ss_compareStudents
+} ss_SortKey_t;
+
+// Create a struct for the timings and counters of one ss_sortFile call.
+// Times, compares and allocations are 0 unless ss_collectStats is on.
+typedef struct ss_Stats {
+	double read_seconds; // Reading and checking the input
+	double sort_seconds;
+	double write_seconds; // Writing the output, and spilling runs with a memory budget
+	size_t records_d; // Domestic students read
+	size_t records_i; // International students read
+	size_t records_a; // All students read
+	uint64_t compares; // Compares of two students
+	uint64_t allocations; // Calls of malloc, calloc and realloc
+	uint64_t bytes_read;
+	uint64_t bytes_written;
+} ss_Stats_t;
+
+// Create a struct for the command line arguments
+typedef struct ss_Options {
+	const char *input_name;
+	const char *output_name;
+	int option; // 1 domestic, 2 international, 3 all, 4 all three at once
+	ss_SortMode_t sort_mode;
+	int threads; // Threads for the parallel sort and for reading large input files
+	size_t memory; // Bytes of students to hold before spilling to disk, 0 for no limit
+	size_t top; // Students to write for --top, 0 for all
+	ss_Stats_t *stats; // Filled in by ss_sortFile when not NULL
+	const char *snapshot_name; // Binary copy of the checked input, read instead of it when up to date, NULL for none
+	const ss_SortKey_t *key; // Order to sort by, NULL for the default order of ss_compareStudents
+	const char *cache_name; // Directory of outputs by hash of input and option, NULL for no cache
+	size_t cache_size; // Bytes the cache may hold before the least recently used outputs go
+} ss_Options_t;
+
+/**
+ * Function to set options to their defaults.
+ * Merge sort, one thread per core, no memory budget, no top count and no cache.
+ */
+void ss_initOptions(ss_Options_t *options);
+
+/**
+ * Function to read students from text in memory.
+ * Same format and errors as an input file. Students point into data, so it
+ * must outlive the list. Sets encoding to 'W' if lines end in "\r\n", else 'U'.
+ */
+bool ss_parseBuffer(const char *data, size_t length, ss_StudentList_t *list, char *encoding, ss_Result_t *result);
+
+/**
+ * Function to turn timing of phases and counting of compares and allocations
+ * on or off. Off by default, so reading and sorting pay nothing for them.
+ * Call before any thread starts reading or sorting.
+ */
+void ss_collectStats(bool enabled);
+
+/**
+ * Function to compile a key spec into a sort order.
+ * The spec is a comma separated list of fields, each optionally followed by
+ * ":asc" or ":desc". Fields are year, month, day, last, first, gpa, toefl and
+ * status. Fields left out follow in the default order, ascending.
+ * For example "gpa:desc,last" sorts by GPA from highest, then last name,
+ * then year, month, day, first name, TOEFL and status.
+ */
+bool ss_compileSortKey(const char *spec, ss_SortKey_t *key, ss_Result_t *result);
+
+/**
+ * Function to pick the list to sort for the option.
+ * 1 for domestic, 2 for international and 3 for all students.
+ */
+ss_ListNode_t *ss_selectList(ss_StudentList_t *list, const int option);
+
+/**
+ * Function to compare students by all fields.
+ * Year, month, day, last name, first name, GPA, TOEFL then status.
+ * Names compare by text, so students of different lists can be compared.
+ */
+int ss_compareStudents(ss_Student_t *a, ss_Student_t *b);
+
+/**
+ * Function to sort a linked list using merge sort.
+ * Stable, so ties keep their order.
+ */
+void ss_sortList(ss_ListNode_t **head);
+
+/**
+ * Function to sort a list with the sort mode from the options.
+ * Every sort mode gives the same order as ss_sortList. With a custom options->key,
+ * every sort mode sorts by that key instead, using a radix sort on each
+ * student encoded once into a number, so any key sorts as fast as the default.
+ */
+void ss_sortStudents(ss_ListNode_t **head, const ss_Options_t *options);
+
+/**
+ * Function to write a list as text in memory, in the input format.
+ * Returns the text, to be freed with free, and sets length. Returns NULL on error.
+ */
+char *ss_serializeList(ss_ListNode_t *head, const char *encoding, size_t *length, ss_Result_t *result);
+
+/**
+ * Function to write a list to an open output file.
+ * The output file is closed even if writing fails.
+ */
+bool ss_writeFile(FILE *output, ss_ListNode_t *head, const char *encoding, ss_Result_t *result);
+
+/**
+ * Function to read, sort and write the files named in the options.
+ * Option 4 writes each list to <output_name>.<option>. Large input files are
+ * read in chunks on options->threads threads, with the same result.
+ * With options->snapshot_name, the students are loaded from that snapshot if
+ * it was made from the same input file, skipping the parse. Otherwise the
+ * input is read and, if it is valid, saved there sorted for the next call.
+ * Not used with a top count or a memory budget.
+ * A custom options->key cannot be used with a top count or a memory budget.
+ * With options->cache_name, an earlier output for the same input bytes,
+ * option and top count is copied to the output file without reading the
+ * students. Option 4 is not cached.
+ * The list is emptied afterwards but keeps its memory for the next call.
+ */
+bool ss_sortFile(const ss_Options_t *options, ss_StudentList_t *list, ss_Result_t *result);
+
+/**
+ * Function to load all students of a list into a new index, in sort order.
+ * The list itself is not changed. The index points to the students of the
+ * list, so the list must outlive it. Returns NULL on error.
+ */
+ss_StudentIndex_t *ss_createIndex(const ss_StudentList_t *list, ss_Result_t *result);
+
+/**
+ * Function to add a student to an index, after any equal students.
+ * The student and its text are copied, so it can come from any list.
+ * Takes O(log n) compares on average.
+ */
+bool ss_insertStudent(ss_StudentIndex_t *index, const ss_Student_t *student, ss_Result_t *result);
+
+/**
+ * Function to remove the first student of an index that compares equal to a student.
+ * Returns false if there is none. Takes O(log n) compares on average.
+ */
+bool ss_removeStudent(ss_StudentIndex_t *index, const ss_Student_t *student);
+
+/**
+ * Function to get the students of an index in sort order, for ss_writeFile or
+ * ss_serializeList. The list belongs to the index, so do not sort or change it.
+ * It stays valid until the index is next changed.
+ */
+ss_ListNode_t *ss_indexList(const ss_StudentIndex_t *index);
+
+/**
+ * Function to count the students of an index.
+ */
+size_t ss_indexCount(const ss_StudentIndex_t *index);
+
+/**
+ * Function to free an index and the students added to it.
+ */
+void ss_freeIndex(ss_StudentIndex_t *index);
+
+/**
+ * Function to empty the linked lists but keep the memory of the arena.
+ * Lets a caller that keeps running reuse the list for the next input.
+ */
+void ss_clearList(ss_StudentList_t *list);
+
+/**
+ * Function to free the linked lists.
+ */
+void ss_freeList(ss_StudentList_t *list);
+
+#endif
@@ -0,0 +1,292 @@
+// Built together with the library, so the tests can pick the scanner and
+// read even short rosters in chunks
+#define PARSE_GRAIN 64
+# include "../studentsort.c"
+
+// Failed checks, so every check runs before the test exits
+int failures = 0;
+
+// Create a struct for everything reading an input gives
+typedef struct Outcome {
+	bool read;
+	ss_ResultCode_t code;
+	const char *message;
+	size_t line;
+	size_t column;
+	char encoding;
+	char *text; // Students kept, serialized, NULL if none
+	size_t length;
+} Outcome_t;
+
+/**
+ * Function to get the next random number, using xorshift64*.
+ */
+uint64_t nextRandom(uint64_t *state) {
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 2685821657736338717ULL;
+}
+
+/**
+ * Function to add a random name of 1 to 40 letters, so lines cross blocks.
+ */
+size_t addName(char *text, uint64_t *state) {
+	size_t length = 1 + (size_t) (nextRandom(state) % 40);
+	for (size_t i = 0; i < length; i++) text[i] = (char) (((i == 0) ? 'A' : 'a') + nextRandom(state) % 26);
+	return length;
+}
+
+/**
+ * Function to make a roster of random valid students, some lines ending in "\r\n".
+ * The text is allocated with room for the mutations of mutateRoster.
+ */
+char *makeRoster(uint64_t *state, int rows, size_t *length) {
+	const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+	char *text = (char *) malloc((size_t) rows * 128 + 64);
+	if (text == NULL) return NULL;
+	bool windows = nextRandom(state) % 4 == 0;
+	size_t at = 0;
+	for (int i = 0; i < rows; i++) {
+		at += addName(text + at, state);
+		text[at++] = ' ';
+		at += addName(text + at, state);
+		at += (size_t) sprintf(text + at, " %s-%d-%d %d.%d", months[nextRandom(state) % 12], 1 + (int) (nextRandom(state) % 31),
+			1950 + (int) (nextRandom(state) % 61), (int) (nextRandom(state) % 4), (int) (nextRandom(state) % 10));
+		if (nextRandom(state) % 2 == 0) at += (size_t) sprintf(text + at, " D");
+		else at += (size_t) sprintf(text + at, " I %d", (int) (nextRandom(state) % 121));
+		at += (size_t) sprintf(text + at, windows ? "\r\n" : "\n");
+	}
+	*length = at;
+	return text;
+}
+
+/**
+ * Function to make one random change to a roster, which most often makes it invalid.
+ * Inserts or replaces a byte the scanners treat specially, or cuts the end.
+ */
+void mutateRoster(char *text, size_t *length, uint64_t *state) {
+	const char bytes[] = {' ', ' ', '\t', '\r', '\n', '\v', '\f', '\0', '-', '.', 'x', '7', (char) 0xC3, (char) 0xFF};
+	size_t at = (size_t) (nextRandom(state) % (*length + 1));
+	char byte = bytes[nextRandom(state) % sizeof(bytes)];
+	switch (nextRandom(state) % 4) {
+		case 0: // Insert
+			memmove(text + at + 1, text + at, *length - at);
+			text[at] = byte;
+			(*length)++;
+			break;
+		case 1: // Replace
+			if (at < *length) text[at] = byte;
+			break;
+		case 2: // Delete
+			if (at < *length) {
+				memmove(text + at, text + at + 1, *length - at - 1);
+				(*length)--;
+			}
+			break;
+		default: // Cut, which may leave the last line without its newline
+			*length = at;
+			break;
+	}
+}
+
+/**
+ * Function to keep what reading gave, and free the list.
+ */
+void keepOutcome(bool read, ss_Result_t *result, char encoding, ss_StudentList_t *list, Outcome_t *outcome) {
+	memset(outcome, 0, sizeof(*outcome));
+	outcome->read = read;
+	if (!read) {
+		outcome->code = result->code;
+		outcome->message = result->message;
+		outcome->line = result->line;
+		outcome->column = result->column;
+	}
+	outcome->encoding = encoding;
+	ss_Result_t ignored;
+	if (list->head_a != NULL) outcome->text = ss_serializeList(list->head_a, &encoding, &outcome->length, &ignored);
+	ss_freeList(list);
+}
+
+/**
+ * Function to read a roster a character at a time, as from a pipe.
+ * This is the path every faster one must match.
+ */
+void readByCharacter(const char *text, size_t length, Outcome_t *outcome) {
+	ss_StudentList_t list = {0};
+	ss_Result_t result;
+	char encoding = 'U';
+	bool more;
+	FILE *file = (length != 0) ? fmemopen((void *) text, length, "r") : fopen("/dev/null", "r"); // fmemopen may refuse a size of 0
+	Input_t input = {file, NULL, 0, 0, 0, 0, NULL, 0};
+	bool read = readFile(&input, &list, 3, &encoding, 0, &more, &result);
+	if (file != NULL) fclose(file);
+	free(input.buffer);
+	keepOutcome(read, &result, encoding, &list, outcome);
+}
+
+/**
+ * Function to read a roster from memory with one thread, plain lines through the scanner.
+ */
+void readMapped(const char *text, size_t length, Outcome_t *outcome) {
+	ss_StudentList_t list = {0};
+	ss_Result_t result;
+	char encoding = 'U';
+	bool more;
+	Input_t input = {NULL, text, length, 0, 0, 0, NULL, 0};
+	bool read = readFile(&input, &list, 3, &encoding, 0, &more, &result);
+	free(input.buffer);
+	keepOutcome(read, &result, encoding, &list, outcome);
+}
+
+/**
+ * Function to read a roster from memory in chunks on up to thread_count threads.
+ */
+void readChunked(const char *text, size_t length, int thread_count, Outcome_t *outcome) {
+	ss_StudentList_t list = {0};
+	ss_Result_t result;
+	char encoding = 'U';
+	Input_t input = {NULL, text, length, 0, 0, 0, NULL, 0};
+	bool read = readInput(&input, &list, 3, &encoding, thread_count, &result);
+	free(input.buffer);
+	keepOutcome(read, &result, encoding, &list, outcome);
+}
+
+/**
+ * Function to check an outcome against the one of the character loop.
+ */
+void checkOutcome(const char *test, int seed, const Outcome_t *expected, const Outcome_t *actual) {
+	bool same = expected->read == actual->read && expected->code == actual->code &&
+		expected->line == actual->line && expected->column == actual->column &&
+		expected->encoding == actual->encoding && expected->length == actual->length &&
+		(expected->message == actual->message ||
+			(expected->message != NULL && actual->message != NULL && strcmp(expected->message, actual->message) == 0)) &&
+		(expected->length == 0 || memcmp(expected->text, actual->text, expected->length) == 0);
+	if (same) return;
+
+	printf("FAIL %s, seed %d: expected %s at %zu:%zu, got %s at %zu:%zu\n", test, seed,
+		expected->read ? "success" : expected->message, expected->line, expected->column,
+		actual->read ? "success" : actual->message, actual->line, actual->column);
+	failures++;
+}
+
+/**
+ * Function to read valid and mutated rosters with each scanner.
+ * Each must give the students, error, line and column of the character loop.
+ */
+void testScanners(void) {
+	const char *names[] = {"scalar", "sse2", "avx2"};
+	void (*scanners[3])(const char *, size_t, BlockMasks_t *) = {scanBlockScalar, NULL, NULL};
+	pthread_once(&scanner_once, selectScanner); // So readLines keeps the scanner set here
+#ifdef SCAN_X86
+	scanners[1] = scanBlockSSE2;
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) scanners[2] = scanBlockAVX2;
+#endif
+
+	for (int seed = 1; seed <= 400; seed++) {
+		uint64_t state = (uint64_t) seed * 2654435761ULL;
+		size_t length;
+		char *text = makeRoster(&state, 1 + seed % 20, &length);
+		if (text == NULL) {
+			printf("FAIL scanners: Memory could not be allocated.\n");
+			failures++;
+			return;
+		}
+		for (int changes = (int) (seed % 4); changes > 0; changes--) mutateRoster(text, &length, &state);
+
+		Outcome_t expected;
+		readByCharacter(text, length, &expected);
+		for (int s = 0; s < 3; s++) {
+			if (scanners[s] == NULL) continue;
+			scanBlock = scanners[s];
+			Outcome_t actual;
+			readMapped(text, length, &actual);
+			checkOutcome(names[s], seed, &expected, &actual);
+			free(actual.text);
+		}
+		free(expected.text);
+		free(text);
+	}
+	selectScanner();
+}
+
+/**
+ * Function to read valid and mutated rosters in chunks of a few lines.
+ * With several thread counts, the students and the first error by line
+ * must be those of the character loop.
+ */
+void testChunks(void) {
+	const int thread_counts[] = {2, 3, 4, 8, 16};
+	char name[32];
+
+	for (int seed = 1; seed <= 300; seed++) {
+		uint64_t state = (uint64_t) seed * 40503ULL + 11;
+		size_t length;
+		char *text = makeRoster(&state, 20 + seed % 60, &length);
+		if (text == NULL) {
+			printf("FAIL chunks: Memory could not be allocated.\n");
+			failures++;
+			return;
+		}
+		for (int changes = (int) (seed % 5); changes > 0; changes--) mutateRoster(text, &length, &state);
+
+		Outcome_t expected;
+		readByCharacter(text, length, &expected);
+		for (int t = 0; t < 5; t++) {
+			Outcome_t actual;
+			readChunked(text, length, thread_counts[t], &actual);
+			snprintf(name, sizeof(name), "chunks on %d threads", thread_counts[t]);
+			checkOutcome(name, seed, &expected, &actual);
+			free(actual.text);
+		}
+		free(expected.text);
+		free(text);
+	}
+}
+
+/**
+ * Function to read one student with each GPA text, which must be rejected
+ * unless it is a plain decimal the stored value keeps exactly.
+ */
+void testGPAs(void) {
+	const char *rejected[] = {"1e-5", "15e-5", "4E-1", ".4e1", "+0x.1", "nan", "inf", "01.5", "4.31", "1.2345"};
+	const char *accepted[] = {"4.3", "+1.5", ".1234", "0.123", "3."};
+	const uint16_t values[] = {43000, 15000, 1234, 1230, 30000};
+	char text[64];
+
+	for (size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); i++) {
+		Outcome_t outcome;
+		int length = snprintf(text, sizeof(text), "Ann Lee Jan-1-2000 %s D\n", rejected[i]);
+		readMapped(text, (size_t) length, &outcome);
+		if (outcome.read || outcome.message == NULL || strcmp(outcome.message, "Error: Invalid GPA.") != 0) {
+			printf("FAIL GPA \"%s\": expected Error: Invalid GPA.\n", rejected[i]);
+			failures++;
+		}
+		free(outcome.text);
+	}
+	for (size_t i = 0; i < sizeof(accepted) / sizeof(accepted[0]); i++) {
+		ss_StudentList_t list = {0};
+		ss_Result_t result;
+		char encoding = 'U';
+		int length = snprintf(text, sizeof(text), "Ann Lee Jan-1-2000 %s D\n", accepted[i]);
+		if (!ss_parseBuffer(text, (size_t) length, &list, &encoding, &result) || list.head_a == NULL ||
+			list.head_a->student->gpa_value != values[i]) {
+			printf("FAIL GPA \"%s\": expected a value of %u\n", accepted[i], (unsigned) values[i]);
+			failures++;
+		}
+		ss_freeList(&list);
+	}
+}
+
+/**
+ * Tests of reading, against the character loop.
+ */
+int main(void) {
+	testScanners();
+	testChunks();
+	testGPAs();
+
+	if (failures == 0) printf("All parse tests passed.\n");
+	return failures == 0 ? 0 : 1;
+}
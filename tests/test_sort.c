@@ -0,0 +1,204 @@
+# include <stdio.h>
+# include <stdint.h>
+# include <stdlib.h>
+# include <string.h>
+# include "studentsort.h"
+
+// Failed checks, so every check runs before the test exits
+int failures = 0;
+
+/**
+ * Function to report a check that failed.
+ */
+void fail(const char *test, const char *message) {
+	printf("FAIL %s: %s\n", test, message);
+	failures++;
+}
+
+/**
+ * Function to parse a roster into a list, failing the test on an error.
+ */
+void parse(const char *test, const char *text, ss_StudentList_t *list) {
+	ss_Result_t result;
+	char encoding;
+	if (!ss_parseBuffer(text, strlen(text), list, &encoding, &result)) fail(test, result.message);
+}
+
+/**
+ * Function to check the last names of a list against names separated by spaces.
+ */
+void checkLastNames(const char *test, ss_ListNode_t *head, const char *expected) {
+	char names[256] = "";
+	size_t length = 0;
+	for (ss_ListNode_t *current = head; current != NULL && length + 64 < sizeof(names); current = current->next) {
+		ss_Slice_t name = current->student->last_name;
+		length += (size_t) snprintf(names + length, sizeof(names) - length, "%s%.*s", (length > 0) ? " " : "",
+			(int) name.length, name.text);
+	}
+	if (strcmp(names, expected) != 0) {
+		char message[512];
+		snprintf(message, sizeof(message), "got \"%s\", expected \"%s\"", names, expected);
+		fail(test, message);
+	}
+}
+
+/**
+ * Function to sort a list joined from two parsed lists with every sort mode.
+ * Ranks from reading belong to the table of each list, so the names of the
+ * two lists must still sort by their text.
+ */
+void testJoinedLists(void) {
+	const char *first = "Zed Zulu Jan-1-2000 3.0 D\n";
+	const char *second = "Amy Adams Jan-1-2000 3.0 D\nBob Brown Jan-1-2000 3.0 D\nCal Crane Jan-1-2000 3.0 D\n";
+	const char *expected = "Adams Brown Crane Zulu";
+	const char *modes[] = {"merge", "radix", "natural", "parallel"};
+
+	for (int mode = -1; mode < 4; mode++) {
+		const char *test = (mode < 0) ? "joined lists, ss_sortList" : modes[mode];
+		ss_StudentList_t a = {0};
+		ss_StudentList_t b = {0};
+		parse(test, first, &a);
+		parse(test, second, &b);
+
+		ss_ListNode_t *head = a.head_a;
+		a.tail_a->next = b.head_a;
+		if (mode < 0) {
+			ss_sortList(&head);
+		} else {
+			ss_Options_t options;
+			ss_initOptions(&options);
+			options.sort_mode = (ss_SortMode_t) mode;
+			ss_sortStudents(&head, &options);
+		}
+		checkLastNames(test, head, expected);
+
+		// Nodes are freed with the arena of their list, whatever they link to
+		ss_freeList(&a);
+		ss_freeList(&b);
+	}
+}
+
+/**
+ * Function to get the next random number, using xorshift64*.
+ */
+uint64_t nextRandom(uint64_t *state) {
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 2685821657736338717ULL;
+}
+
+/**
+ * Function to make a roster of random students from a few names, so many tie.
+ * The text is allocated, and must outlive the list it is parsed into.
+ */
+char *makeRoster(uint64_t *state, int rows) {
+	const char *names[] = {"Ann", "Bo", "Cy", "Dee", "Eve", "Flo", "Gus", "Hal", "Ida", "Jo", "Kai", "Lu"};
+	const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+	char *text = (char *) malloc((size_t) rows * 64 + 1);
+	if (text == NULL) return NULL;
+	size_t length = 0;
+	text[0] = '\0';
+	for (int i = 0; i < rows; i++) {
+		const char *first = names[nextRandom(state) % 12];
+		const char *last = names[nextRandom(state) % 12];
+		length += (size_t) sprintf(text + length, "%s %s %s-%d-%d %d.%d", first, last, months[nextRandom(state) % 3],
+			1 + (int) (nextRandom(state) % 3), 1990 + (int) (nextRandom(state) % 2), (int) (nextRandom(state) % 4),
+			(int) (nextRandom(state) % 10));
+		if (nextRandom(state) % 2 == 0) length += (size_t) sprintf(text + length, " D\n");
+		else length += (size_t) sprintf(text + length, " I %d\n", (int) (nextRandom(state) % 3) + 100);
+	}
+	return text;
+}
+
+/**
+ * Function to sort students from several sources with every sort mode.
+ * The list mixes three parsed lists, one of them parsed twice, and students
+ * built by hand whose ranks were never set. Every mode must give exactly the
+ * order of ss_sortList, which compares the text of names.
+ */
+void testMixedLists(void) {
+	const char *test = "mixed lists";
+	const int rows = 3000; // Over the grain of the parallel sort once joined
+	const char *modes[] = {"merge", "radix", "natural", "parallel"};
+	uint64_t state = 2510;
+	char *texts[4];
+	ss_StudentList_t lists[3] = {{0}};
+	for (int i = 0; i < 4; i++) {
+		texts[i] = makeRoster(&state, rows);
+		if (texts[i] == NULL) {
+			fail(test, "Memory could not be allocated.");
+			return;
+		}
+		parse(test, texts[i], &lists[i % 3]); // The first list is parsed twice, so its names are ranked again
+	}
+
+	// Students built by hand, copied from the first list with their ranks left 0
+	const int built = 200;
+	ss_Student_t *students = (ss_Student_t *) calloc(built, sizeof(ss_Student_t));
+	size_t count = 0;
+	for (int i = 0; i < 3; i++)
+		for (ss_ListNode_t *current = lists[i].head_a; current != NULL; current = current->next) count++;
+	ss_ListNode_t *nodes = (ss_ListNode_t *) malloc(sizeof(ss_ListNode_t) * (count + built));
+	ss_ListNode_t **expected = (ss_ListNode_t **) malloc(sizeof(ss_ListNode_t *) * (count + built));
+	if (students == NULL || nodes == NULL || expected == NULL) {
+		fail(test, "Memory could not be allocated.");
+		count = 0;
+	}
+
+	// Deal the students of the lists out in turn, so the sources interleave
+	size_t total = 0;
+	ss_ListNode_t *heads[3] = {lists[0].head_a, lists[1].head_a, lists[2].head_a};
+	for (size_t dealt = 0; dealt < count;) {
+		for (int i = 0; i < 3; i++) {
+			if (heads[i] == NULL) continue;
+			nodes[total++].student = heads[i]->student;
+			heads[i] = heads[i]->next;
+			dealt++;
+		}
+	}
+	ss_ListNode_t *source = lists[0].head_a;
+	for (int i = 0; i < built && source != NULL && count > 0; i++, source = source->next) {
+		students[i] = *source->student;
+		students[i].last_rank = 0;
+		students[i].first_rank = 0;
+		students[i].rank_set = 0;
+		nodes[total++].student = &students[i];
+	}
+
+	for (int mode = -1; mode < 4 && total > 0; mode++) {
+		for (size_t i = 0; i < total; i++) nodes[i].next = (i + 1 < total) ? &nodes[i + 1] : NULL;
+		ss_ListNode_t *head = nodes;
+		if (mode < 0) {
+			ss_sortList(&head);
+			for (size_t i = 0; i < total; i++, head = head->next) expected[i] = head;
+			continue;
+		}
+
+		ss_Options_t options;
+		ss_initOptions(&options);
+		options.sort_mode = (ss_SortMode_t) mode;
+		options.threads = 4;
+		ss_sortStudents(&head, &options);
+		size_t i = 0;
+		for (; head != NULL && i < total && head == expected[i]; head = head->next) i++;
+		if (head != NULL || i != total) fail(modes[mode], "order differs from ss_sortList on mixed lists");
+	}
+
+	free(expected);
+	free(nodes);
+	free(students);
+	for (int i = 0; i < 3; i++) ss_freeList(&lists[i]);
+	for (int i = 0; i < 4; i++) free(texts[i]);
+}
+
+/**
+ * Tests of sorting through the public header.
+ */
+int main(void) {
+	testJoinedLists();
+	testMixedLists();
+
+	if (failures == 0) printf("All sort tests passed.\n");
+	return failures == 0 ? 0 : 1;
+}